@@ -12,17 +12,10 @@
 
 namespace Matrix {
     // Currently we only support 8-bit port
+    //  Storage of a bank, every algorithm lays out its lines in its own Buffer. (See Matrix/<FAMILY>/<ALG>/algorithm.h)
     struct Buffer {
-        public:
-            Buffer();
-
-            void set_value(uint8_t multiplex, uint16_t index, uint8_t column, uint8_t value);
-            uint8_t *get_line(uint8_t multiplex, uint16_t index);
-            
-            static uint8_t get_line_length();
-
-        private:
-            uint8_t buf[Serial::max_framebuffer_size];
+        protected:
+            alignas(4) uint8_t buf[Serial::max_framebuffer_size];
     };
 }
 
@@ -7,57 +7,126 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include <stdint.h>
 #include "Matrix/Buffer.h"
 
 namespace Matrix {
     /**
      *  @brief Starts Matrix state machine.
-     *  @details Implemented in Matrix/<implementation>/matrix.cpp
+     *  @details Implemented in Matrix/engine_api.h for Matrix/<implementation>/matrix.cpp
      */
     void start();
     
     /**
      *  @brief Matrix state machine ISR from DMA/PIO.
      *  @details Mapped to ISR in src/<app>/isr.cpp
-     *  @details Implemented in Matrix/<implementation>/matrix.cpp
+     *  @details Implemented in Matrix/engine_api.h for Matrix/<implementation>/matrix.cpp
+     *  @details With DMA_SCAN this only fires once per refresh and timer_isr is not used.
      */
     void dma_isr();
     
+    /**
+     *  @brief Matrix ISR from PIO at the end of every row.
+     *  @details Mapped to ISR in src/<app>/isr.cpp
+     *  @details Implemented in Matrix/engine_api.h for Matrix/<implementation>/matrix.cpp
+     *  @details Not used with DMA_SCAN.
+     */
+    void pio_isr();
+    
     /**
      *  @brief Matrix ISR from Blank time.
      *  @details Mapped to ISR in src/<app>/isr.cpp
-     *  @details Implemented in Matrix/<implementation>/matrix.cpp
+     *  @details Implemented in Matrix/engine_api.h for Matrix/<implementation>/matrix.cpp
      *  @details This may be capable of being rendered into a coprocessor. (Currently just interrupts core 0.)
      */
     void timer_isr();
 
     /**
      *  @brief Variable used to capture timer/alarm index
-     *  @details Implemented in Matrix/<implementation>/matrix.cpp
+     *  @details Implemented in Matrix/engine_api.h for Matrix/<implementation>/matrix.cpp
      */
     extern volatile int timer;
+
+    /**
+     *  @brief Function used to select the depth profile of the display
+     *  @details Implemented in Matrix/engine_api.h for Matrix/<implementation>/matrix.cpp
+     *  @details Profiles trade depth for refresh, they are verified at compile time. (Profile 0 is the configuration.)
+     *  @details Does not block, takes effect with the next refresh. Returns false if the profile does not exist.
+     *  @details Profiles of an engine follow each other by algorithm, one of another algorithm switches at a frame boundary. (See Matrix/engine.h)
+     */
+    bool set_profile(uint8_t profile);
     
     // This can be rendered into coprocessor. (Currently this is done via super loop on core 1.)
     namespace Worker {
         /**
          *  @brief State machine for converting RGB-24 to bitplanes.
          *  @details Usually runs on Core 1 processing buffers passed over FIFO from Core 0.
-         *  @details Implemented in Matrix/<implementation>/worker.cpp
+         *  @details Implemented in Matrix/engine_api.h for Matrix/<implementation>/worker.cpp
          */
         void work();
+
+        /**
+         *  @brief Function used to convert rows of the current packet on another core.
+         *  @details Usually called from Core 0 between serial polls. Converts at most one row per call.
+         *  @details Implemented in Matrix/engine_api.h for Matrix/<implementation>/worker.cpp
+         */
+        void assist();
         
         /**
          *  @brief Function used to pass data to worker (Assumes flow control)
-         *  @details Implemented in Matrix/<implementation>/worker.cpp
+         *  @details Implemented in Matrix/engine_api.h for Matrix/<implementation>/worker.cpp
+         *  @details Does not block, returns false if the queue is full. (Frame is dropped, buffer stays with the caller.)
+         *  @details Accepted buffer is owned by the worker until it is converted or a newer frame replaces it.
          */
-        void process(Serial::packet *buffer);
+        bool process(Serial::packet *buffer);
 
         /**
          *  @brief Function used to pass data thru worker (Assumes flow control)
-         *  @details Implemented in Matrix/<implementation>/worker.cpp
+         *  @details Implemented in Matrix/engine_api.h for Matrix/<implementation>/worker.cpp
          *  @details Buffer is copied into back buffer. (Do not use front or back buffer(s).)
+         *  @details Buffer is in the memory format of the current algorithm, for example Matrix::BCM::Buffer.
+         *  @details Does not block, returns false if the queue is full.
+         */
+        bool process(Matrix::Buffer *buffer);
+
+        /**
+         *  @brief Function used to replace the color tables of the worker (Gamma and white balance)
+         *  @details Implemented in Matrix/engine_api.h for Matrix/<implementation>/worker.cpp
+         *  @details Red, green and blue tables of Serial::range_high PWM values each. (See Matrix/color.h)
+         *  @details Does not block, returns false if the previous tables were not taken yet or the RGB type has no tables.
+         */
+        bool set_color(const uint16_t *table);
+
+        /**
+         *  @brief Function used to write one page of the dot correction table (Flash)
+         *  @details Implemented in Matrix/engine_api.h for Matrix/<implementation>/worker.cpp
+         *  @details Page of FLASH_PAGE_SIZE coefficients, red, green and blue of every pixel. (See Matrix/dot.h)
+         *  @details Blocks until the page is written, returns false if the page is out of range.
+         */
+        bool set_dot(uint16_t page, const uint8_t *data);
+
+        // Counters are only written by the worker and the Matrix ISRs. (Read only for everyone else.)
+        struct Statistics {
+            uint32_t rows_skipped;          // Row matched the bank being replaced (Hit)
+            uint32_t rows_copied;           // Row matched the previous bank (Hit)
+            uint32_t rows_converted;        // Row was converted (Miss)
+            uint32_t frames_skipped;        // Frame matched the previous frame
+            uint32_t lines_shared;          // Line matched the line before it and shares its memory (PWM only)
+            uint32_t lines_blank;           // Line was blank and uses the null line (PWM only)
+            uint32_t frames_dropped;        // Frame was replaced by a newer one before it was displayed
+            uint32_t frames_repeated;       // Display started a refresh without a new frame
+            uint32_t swap_latency_us;       // Time from publishing the last frame to displaying it
+            uint32_t swap_latency_max_us;   // Largest swap_latency_us seen
+            uint32_t frames_coalesced;      // Frame was still queued when a newer one arrived and was never converted
+            uint32_t frames_rejected;       // Frame arrived while the queue was full
+            uint32_t queue_depth_max;       // Most frames queued at once (Includes the frame being converted)
+        };
+
+        /**
+         *  @brief Function used to read the worker counters
+         *  @details Implemented in Matrix/engine_api.h for Matrix/<implementation>/worker.cpp
          */
-        void process(Matrix::Buffer *buffer);
+        const volatile Statistics *get_statistics();
     }
 }
 
@@ -0,0 +1,44 @@
+/* 
+ * File:   hw_config.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+ 
+#ifndef MATRIX_HW_CONFIG_H
+#define MATRIX_HW_CONFIG_H
+
+#include <stdint.h>
+#include "Matrix/config.h"
+
+namespace Matrix::GCLK {
+    constexpr uint16_t GCLK_DATA_BASE = 8;
+    constexpr uint16_t GCLK_GCLK = 22;                  // OE pin of the HUB75 connector
+
+    // Driver commands are the number of DCLK rising edges with LE (LAT) high.
+    //  Widths are the ones of the command table in the Chipone ICN2053 datasheet, which is public.
+    //      Data latch is 1, VSYNC is 3, write configuration register 1 is 4 and pre-active is 14.
+    //      Other drivers of this kind may use other widths, check the command table of the driver.
+    constexpr uint8_t GCLK_LE_DATA_LATCH = 1;
+    constexpr uint8_t GCLK_LE_VSYNC = 3;
+    constexpr uint8_t GCLK_LE_WRITE_CONFIG = 4;
+    constexpr uint8_t GCLK_LE_PRE_ACTIVE = 14;
+
+    // Configuration register written to every driver at start, zero keeps the power on defaults.
+    constexpr uint16_t GCLK_CONFIG = 0;
+
+    // Driver shifts 16 bits per channel and 16 channels per driver.
+    constexpr uint8_t GCLK_CHANNEL_BITS = 16;
+    constexpr uint8_t GCLK_CHANNELS = 16;
+
+    // GCLKs per row per sub period including the dead time of the driver. (Set by the driver configuration)
+    //  Driver splits the grayscale into sub periods of GCLK_PER_ROW - 1 steps and scans every row once per sub period.
+    constexpr uint16_t GCLK_PER_ROW = 513;
+
+    // -- DO NOT EDIT BELOW THIS LINE --
+
+    // Order (LSB to MSB): R0 G0 B0 R1 G1 B1 (repeated for every chain) DCLK LE
+    constexpr uint16_t GCLK_DATA_LEN = (6 * Matrix::CHAINS) + 2;
+    constexpr uint16_t GCLK_DCLK = GCLK_DATA_BASE + (6 * Matrix::CHAINS);
+}
+
+#endif
@@ -10,17 +10,24 @@
 #include <stdint.h>
 #include "Serial/config.h"
 
-namespace Matrix::Worker {
+namespace Matrix::BCM::Worker {
     template <typename T> struct BCM_worker {
         public:
             BCM_worker();
+            void reset();
             void process_packet(Serial::packet *p);
-            void save_buffer(Matrix::Buffer *p);
+            void save_buffer(Buffer *p);
+            bool process_row();
 
         private:
             void build_index_table();
+            static uint16_t get_value(uint16_t v, uint8_t c, const uint8_t *k, uint8_t t);
+            static uint32_t get_hash(uint8_t y, Serial::packet *p);
+            void copy_row(uint8_t y, uint8_t src);
+            void set_row(uint8_t y, Serial::packet *p);
             T *get_table(uint16_t v, uint8_t i, uint8_t nibble);
-            void set_pixel(uint8_t x, uint8_t y, uint16_t r0, uint16_t g0, uint16_t b0, uint16_t r1, uint16_t g1, uint16_t b1);
+            void set_pixel(uint16_t x, uint8_t y, uint8_t chain, uint16_t r0, uint16_t g0, uint16_t b0, uint16_t r1, uint16_t g1, uint16_t b1);
+            void set_pixels(uint16_t x, uint8_t y, uint8_t chain, Serial::packet *p);
 
             union index_table_t {
                 T table[16][6][4 / sizeof(T)];
@@ -28,6 +35,10 @@ namespace Matrix::Worker {
             };
             
             index_table_t index_table;
+
+            // Rows of every bank are hashed to skip conversion of unchanged rows
+            uint32_t hash[Serial::num_framebuffers][MULTIPLEX];
+            bool valid[Serial::num_framebuffers];
     };
 }
 
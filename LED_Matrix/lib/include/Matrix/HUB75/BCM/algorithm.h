@@ -0,0 +1,81 @@
+/* 
+ * File:   algorithm.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+ 
+#ifndef MATRIX_HUB75_BCM_ALGORITHM_H
+#define MATRIX_HUB75_BCM_ALGORITHM_H
+
+#include <stdint.h>
+#include "Serial/config.h"
+#include "Matrix/config.h"
+#include "Matrix/Buffer.h"
+
+// BCM algorithm as seen by Matrix::Engine (See Matrix/engine.h)
+//  Declarations only, like PWM the format stays with the sources.
+namespace Matrix::BCM {
+    // Bank in the BCM memory format (See Buffer.cpp)
+    struct Buffer : public Matrix::Buffer {
+        public:
+            Buffer();
+
+            void set_value(uint8_t multiplex, uint16_t index, uint16_t column, uint8_t chain, uint8_t value);
+            void set_word(uint8_t multiplex, uint16_t index, uint16_t column, uint8_t chain, uint32_t value);
+            uint8_t *get_line(uint8_t multiplex, uint16_t index);
+
+            static uint16_t get_line_length();              // Bytes, always whole words
+            static uint8_t get_column_offset();             // Bytes from the start of a line to column 0
+    };
+
+    // Display (See matrix.cpp)
+    void init();                                            // Pins and programs (Once)
+    void resume();                                          // Takes both state machines and DMA, starts row 0 of the front bank
+    void suspend();                                         // Gives them back at a frame boundary, SIO holds OE off
+    void dma_isr();
+    void pio_isr();
+    void timer_isr();
+    bool set_profile(uint8_t profile);
+    uint8_t get_profiles();
+
+    // Worker (See worker.h)
+    namespace Worker {
+        extern Buffer buf[Serial::num_framebuffers];
+
+        Buffer *get_front_buffer(uint8_t *id);
+        void start();                                       // Shares the rows with core 0 (See assist)
+        void reset();                                       // Banks hold nothing that can be reused
+        void process_packet(Serial::packet *p);
+        void save_buffer(Matrix::Buffer *p);
+        void assist();
+        bool set_color(const uint16_t *table);
+    }
+
+    namespace Calculator {
+        void verify_configuration();
+    }
+
+    struct Algorithm {
+        static constexpr void (*init)() = BCM::init;
+        static constexpr void (*resume)() = BCM::resume;
+        static constexpr void (*suspend)() = BCM::suspend;
+        static constexpr void (*dma_isr)() = BCM::dma_isr;
+        static constexpr void (*pio_isr)() = BCM::pio_isr;
+        static constexpr void (*timer_isr)() = BCM::timer_isr;
+        static constexpr bool (*set_profile)(uint8_t) = BCM::set_profile;
+        static constexpr uint8_t (*get_profiles)() = BCM::get_profiles;
+        static constexpr void (*start)() = Worker::start;
+        static constexpr void (*reset)() = Worker::reset;
+        static constexpr void (*process_packet)(Serial::packet *) = Worker::process_packet;
+        static constexpr void (*save_buffer)(Matrix::Buffer *) = Worker::save_buffer;
+        static constexpr void (*assist)() = Worker::assist;
+        static constexpr bool (*set_color)(const uint16_t *) = Worker::set_color;
+
+        // Static SRAM of the worker besides the banks, an upper bound checked against the worker. (See worker.h)
+        //  Index table, then the hashes and valid flags of every bank. (See BCM_worker.h)
+        static constexpr uint32_t scratch_size = (16 * 6 * sizeof(uint32_t)) +
+            (Serial::num_framebuffers * MULTIPLEX * sizeof(uint32_t)) + ((Serial::num_framebuffers + 3) & ~3);
+    };
+}
+
+#endif
@@ -0,0 +1,384 @@
+/* 
+ * File:   worker.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef MATRIX_HUB75_BCM_WORKER_H
+#define MATRIX_HUB75_BCM_WORKER_H
+
+// BCM worker, shared by BCM and GCLK Generic. (See HUB75/BCM/worker.cpp and GCLK/Generic/worker.cpp)
+//  Definitions, included once by the worker.cpp of the algorithm after its memory format and algorithm.h.
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <type_traits>
+#include "pico/multicore.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "Serial/config.h"
+#include "Matrix/matrix.h"
+#include "Matrix/engine.h"
+#include "Matrix/helper.h"
+#include "Matrix/color.h"
+#include "Matrix/dot.h"
+#include "Matrix/dither.h"
+#include "Matrix/map.h"
+#include "Matrix/bitplane.h"
+#include "CRC/CRC.h"
+#include "Matrix/HUB75/BCM/BCM_worker.h"
+
+namespace Matrix::BCM::Worker {
+    Buffer buf[Serial::num_framebuffers];
+    static volatile Matrix::Worker::Statistics &stats = Matrix::Worker::stats;
+    static APP::Color<PWM_bits> &color = Matrix::Worker::color<PWM_bits>;     // Color stage (See Matrix/color.h)
+
+    // Triple buffering (Banks are never copied, only their roles are exchanged)
+    //  bank_front is displayed, bank_ready holds the newest complete frame and bank is written by the worker.
+    //      Worker publishes by swapping bank and bank_ready. A frame still waiting in bank_ready is dropped. (Latest frame wins)
+    //      ISR takes bank_ready at row 0 by swapping it with bank_front. Otherwise the displayed frame is repeated.
+    //  Worker and Matrix ISRs share core 1 (See main.cpp), the worker only masks interrupts for the swap.
+    //      Neither side ever waits for the other.
+    static uint8_t bank = 2;
+    static uint8_t bank_last = 0;                   // Last published bank (Source for copied rows)
+    static volatile uint8_t bank_ready = 1;
+    static volatile uint8_t bank_front = 0;
+    static volatile bool ready_fresh = false;
+    static volatile uint32_t ready_time = 0;
+
+    // Rows of a packet are shared by both cores (See assist)
+    //  RP2040 (Cortex-M0+) has no exclusive load/store, a hardware spinlock guards the row counters.
+    //      Spinlock is only held for a few instructions, neither core can stall the other.
+    enum class ROW_ACTION { SKIP, COPY, CONVERT };
+    static spin_lock_t *volatile row_lock = nullptr;
+    static Serial::packet *volatile row_packet = nullptr;
+    static volatile uint8_t row_next = 0;
+    static volatile uint8_t row_done = 0;
+    static uint8_t row_src = 0;
+    static ROW_ACTION row_action[MULTIPLEX];
+    static bool (*volatile assist_row)() = nullptr;
+
+    // Hands the finished bank to the ISR and recycles the stale one
+    static void __not_in_flash_func(publish)() {
+        uint32_t irq = save_and_disable_interrupts();
+        const uint8_t stale = bank_ready;
+
+        if (ready_fresh)
+            stats.frames_dropped++;
+
+        bank_ready = bank;
+        ready_time = time_us_32();
+        ready_fresh = true;
+        restore_interrupts(irq);
+
+        bank_last = bank;
+        bank = stale;
+    }
+
+    template <typename T> BCM_worker<T>::BCM_worker() {
+        for (uint32_t i = 0; i < sizeof(index_table_t::v) / sizeof(uint32_t); i++)
+            index_table.v[i] = 0;
+        
+        reset();
+        build_index_table();
+    }
+
+    template <typename T> void BCM_worker<T>::reset() {
+        for (uint32_t i = 0; i < Serial::num_framebuffers; i++)
+            valid[i] = false;
+    }
+
+    template <typename T> inline void BCM_worker<T>::build_index_table() {
+        for (uint32_t i = 0; i < 16; i++)
+            for (uint32_t j = 0; j < 4; j++)
+                for (uint8_t k = 0; k < 6; k++)
+                    if (i & (1 << j))
+                        index_table.table[i][k][j / sizeof(T)] |= 1 << (k + ((j % sizeof(T)) * 8));
+    }
+
+    template <typename T> inline void BCM_worker<T>::set_row(uint8_t y, Serial::packet *p) {
+        for (uint8_t chain = 0; chain < CHAINS; chain++) {
+            const uint16_t r = y + (chain * 2 * MULTIPLEX);
+
+            if constexpr ((COLUMNS % 4) == 0) {
+                for (uint16_t x = 0; x < COLUMNS; x += 4) {
+                    set_pixels(x, y, chain, p);
+                }
+            }
+            else {
+                for (uint16_t x = 0; x < COLUMNS; x++) {
+                    const uint32_t m[2] = { APP::Map::get(r, x), APP::Map::get(r + MULTIPLEX, x) };
+                    const Serial::pixel *s[2] = { APP::Map::pixel(p, m[0]), APP::Map::pixel(p, m[1]) };
+                    const uint8_t *dot[2] = { APP::Dot::get(m[0]), APP::Dot::get(m[1]) };
+                    const uint8_t dither[2] = { APP::Dither<PWM_bits>::get(r, x), APP::Dither<PWM_bits>::get(r + MULTIPLEX, x) };
+
+                    set_pixel(x, y, chain, get_value(s[0]->red, 0, dot[0], dither[0]), get_value(s[0]->green, 1, dot[0], dither[0]), get_value(s[0]->blue, 2, dot[0], dither[0]), get_value(s[1]->red, 0, dot[1], dither[1]), get_value(s[1]->green, 1, dot[1], dither[1]), get_value(s[1]->blue, 2, dot[1], dither[1]));
+                }
+            }
+        }
+    }
+
+    template <typename T> inline uint32_t BCM_worker<T>::get_hash(uint8_t y, Serial::packet *p) {
+        uint32_t checksum = 0xFFFFFFFF;
+
+        // Rows y and y + MULTIPLEX of every chain
+        for (uint32_t i = 0; i < (2 * CHAINS); i++) {
+            const uint16_t r = y + (i * MULTIPLEX);
+
+            if constexpr (APP::Map::identity) {
+                const uint8_t *row = (const uint8_t *) p->data[r];
+
+                for (uint32_t j = 0; j < sizeof(p->data[r]); j++)
+                    checksum = CRC::crc32(checksum, row[j]);
+            }
+            else {
+                // Pixels gathered by the row (See Matrix/map.h)
+                for (uint16_t x = 0; x < COLUMNS; x++) {
+                    const uint8_t *px = (const uint8_t *) APP::Map::pixel(p, APP::Map::get(r, x));
+
+                    for (uint32_t j = 0; j < sizeof(Serial::pixel); j++)
+                        checksum = CRC::crc32(checksum, px[j]);
+                }
+            }
+        }
+
+        return ~checksum;
+    }
+
+    // Lines of a row are consecutive (row_length in memory_format.h)
+    template <typename T> inline void BCM_worker<T>::copy_row(uint8_t y, uint8_t src) {
+        memcpy(buf[bank].get_line(y, 0), buf[src].get_line(y, 0), row_length);
+    }
+
+    // Claims the next row of the current packet and processes it.
+    //  Returns false if there is nothing left to claim.
+    template <typename T> inline bool BCM_worker<T>::process_row() {
+        Serial::packet *p = nullptr;
+        uint8_t y = 0;
+        uint32_t irq = spin_lock_blocking(row_lock);
+
+        if ((row_packet != nullptr) && (row_next < MULTIPLEX)) {
+            p = row_packet;
+            y = row_next++;
+        }
+
+        spin_unlock(row_lock, irq);
+
+        if (p == nullptr)
+            return false;
+
+        switch (row_action[y]) {
+            case ROW_ACTION::COPY:
+                copy_row(y, row_src);
+                break;
+            case ROW_ACTION::CONVERT:
+                set_row(y, p);
+                break;
+            default:
+                break;
+        }
+
+        irq = spin_lock_blocking(row_lock);
+        row_done++;
+        spin_unlock(row_lock, irq);
+        __sev();
+
+        return true;
+    }
+
+    // Dirty row tracking:
+    //  Row pairs (y and y + MULTIPLEX) are hashed and compared against the bank being replaced and the last published bank.
+    //      Bank being replaced already holds the row: nothing to do
+    //      Last published bank holds the row: copy the lines
+    //      Otherwise convert the row
+    //  If every row matches the last published bank the frame is dropped, it is already on the way to the display.
+    template <typename T> inline void BCM_worker<T>::process_packet(Serial::packet *p) {
+        // New color or dot correction tables change every row
+        if (color.update() | APP::Dot::update())
+            reset();
+
+        const uint8_t prev = bank_last;
+        uint32_t h[MULTIPLEX];
+        bool dirty = !valid[prev];
+
+        for (uint8_t y = 0; y < MULTIPLEX; y++) {
+            h[y] = get_hash(y, p);
+            dirty |= h[y] != hash[prev][y];
+        }
+
+        if (!dirty) {
+            stats.frames_skipped++;
+            return;
+        }
+
+        for (uint8_t y = 0; y < MULTIPLEX; y++) {
+            if (valid[bank] && (h[y] == hash[bank][y])) {
+                row_action[y] = ROW_ACTION::SKIP;
+                stats.rows_skipped++;
+            }
+            else if (valid[prev] && (h[y] == hash[prev][y])) {
+                row_action[y] = ROW_ACTION::COPY;
+                stats.rows_copied++;
+            }
+            else {
+                row_action[y] = ROW_ACTION::CONVERT;
+                stats.rows_converted++;
+            }
+
+            hash[bank][y] = h[y];
+        }
+
+        uint32_t irq = spin_lock_blocking(row_lock);
+        row_src = prev;
+        row_next = 0;
+        row_done = 0;
+        row_packet = p;
+        spin_unlock(row_lock, irq);
+        __sev();
+
+        while (process_row()) {
+            // Core 0 may take rows between polls
+        }
+
+        while (row_done < MULTIPLEX) {
+            __wfe();
+        }
+
+        valid[bank] = true;
+
+        publish();
+    }
+
+    template <typename T> inline uint16_t BCM_worker<T>::get_value(uint16_t v, uint8_t c, const uint8_t *k, uint8_t t) {
+        return APP::Dither<PWM_bits>::apply(APP::Dot::apply(color.get(c, v), k[c]), t);
+    }
+
+    template <typename T> inline T *BCM_worker<T>::get_table(uint16_t v, uint8_t i, uint8_t nibble) {
+        //v %= (1 << PWM_bits);
+        return index_table.table[(v >> nibble) & ((1 << sizeof(T)) - 1)][i];
+    }
+
+    // Bit sliced version of set_pixel for four columns (one column per byte lane)
+    //  Loads R0 G0 B0 R1 G1 B1 of four columns and transposes these into bitplanes. (See Matrix/bitplane.h)
+    //  Each bitplane is stored as a single word for four columns.
+    template <typename T> inline void BCM_worker<T>::set_pixels(uint16_t x, uint8_t y, uint8_t chain, Serial::packet *p) {
+        const uint16_t r = y + (chain * 2 * MULTIPLEX);
+        uint16_t v[4][6];
+        uint32_t planes[PWM_bits];
+
+        for (uint32_t j = 0; j < 4; j++) {
+            const uint32_t m[2] = { APP::Map::get(r, x + j), APP::Map::get(r + MULTIPLEX, x + j) };
+            const Serial::pixel *s[2] = { APP::Map::pixel(p, m[0]), APP::Map::pixel(p, m[1]) };
+            const uint8_t *dot[2] = { APP::Dot::get(m[0]), APP::Dot::get(m[1]) };
+            const uint8_t dither[2] = { APP::Dither<PWM_bits>::get(r, x + j), APP::Dither<PWM_bits>::get(r + MULTIPLEX, x + j) };
+
+            v[j][0] = get_value(s[0]->red, 0, dot[0], dither[0]);
+            v[j][1] = get_value(s[0]->green, 1, dot[0], dither[0]);
+            v[j][2] = get_value(s[0]->blue, 2, dot[0], dither[0]);
+            v[j][3] = get_value(s[1]->red, 0, dot[1], dither[1]);
+            v[j][4] = get_value(s[1]->green, 1, dot[1], dither[1]);
+            v[j][5] = get_value(s[1]->blue, 2, dot[1], dither[1]);
+        }
+
+        APP::get_planes<PWM_bits>(v, planes);
+
+        for (uint32_t i = 0; i < PWM_bits; i++)
+            buf[bank].set_word(y, i, x, chain, planes[i]);
+    }
+
+    // Tricks: (Branch is index into vector via PC)
+    //  1. Use types (read, write)
+    //  2. Remove if with calculations (multiply and accumulate)
+    //      2.1 SIMD may help
+    //      2.2 Matrix operations may help
+    //  3. Remove if with LUT (needs good cache)
+    //      3.1 Matrix operations may help
+    template <typename T> inline void BCM_worker<T>::set_pixel(uint16_t x, uint8_t y, uint8_t chain, uint16_t r0, uint16_t g0, uint16_t b0, uint16_t r1, uint16_t g1, uint16_t b1) {    
+        for (uint32_t nib = 0; nib < PWM_bits; nib += sizeof(T)) {
+            T *c[6] = { get_table(r0, 0, nib), get_table(g0, 1, nib), get_table(b0, 2, nib), get_table(r1, 3, nib), get_table(g1, 4, nib), get_table(b1, 5, nib) };
+        
+            // Superscalar Operation (forgive the loads)
+            T p = *c[0] | *c[1] | *c[2] | *c[3] | *c[4] | *c[5];
+
+            // Hopefully the compiler will sort this out. (Inlining set_value)
+            for (uint32_t j = 0; j < sizeof(T); j++)
+                buf[bank].set_value(y, nib + j, x, chain, (p >> (j * 8)) & 0xFF);
+        }
+    }
+
+    template <typename T> inline void BCM_worker<T>::save_buffer(Buffer *p) {
+        valid[bank] = false;
+
+        for (uint8_t y = 0; y < MULTIPLEX; y++) {
+            memcpy(buf[bank].get_line(y, 0), p->get_line(y, 0), row_length);
+        }
+
+        publish();
+    }    
+    
+    // Compiler picks one of these, bitplanes are packed into whole words of T. (See get_table)
+    static BCM_worker<std::conditional_t<(PWM_bits % 4) == 0, uint32_t, std::conditional_t<(PWM_bits % 4) == 2, uint16_t, uint8_t>>> worker;
+    static_assert(sizeof(worker) <= Algorithm::scratch_size, "Algorithm::scratch_size does not cover the BCM worker (See algorithm.h)");
+
+    // Worker is shared with core 0 from here on (See assist)
+    void start() {
+        row_lock = spin_lock_init(spin_lock_claim_unused(true));
+        assist_row = []() { return worker.process_row(); };
+    }
+
+    // Banks of another algorithm were displayed in between. (See Matrix/engine.h)
+    void reset() {
+        worker.reset();
+    }
+
+    void process_packet(Serial::packet *p) {
+        worker.process_packet(p);
+    }
+
+    void save_buffer(Matrix::Buffer *p) {
+        worker.save_buffer(static_cast<Buffer *>(p));
+    }
+
+    // Converts at most one row per call, this bounds the polling latency of core 0.
+    void __not_in_flash_func(assist)() {
+        bool (*f)() = assist_row;
+
+        if (f != nullptr)
+            f();
+    }
+
+    // Called from the timer ISR at row 0
+    //  Returns the newest complete bank, or nullptr if the displayed bank is still the newest.
+    //      id always receives the displayed bank.
+    Buffer *__not_in_flash_func(get_front_buffer)(uint8_t *id) {
+        Buffer *result = nullptr;
+
+        if (ready_fresh) {
+            const uint8_t front = bank_front;
+            const uint32_t latency = time_us_32() - ready_time;
+
+            bank_front = bank_ready;
+            bank_ready = front;
+            ready_fresh = false;
+
+            stats.swap_latency_us = latency;
+            stats.swap_latency_max_us = std::max((uint32_t) stats.swap_latency_max_us, latency);
+            result = &buf[bank_front];
+        }
+        else
+            stats.frames_repeated++;
+
+        if (id != nullptr)
+            *id = bank_front;
+
+        return result;
+    }
+
+    // Tables are taken before the next frame is converted. (See Matrix/color.h)
+    bool set_color(const uint16_t *table) {
+        return color.load(table);
+    }
+}
+
+#endif
@@ -7,25 +7,44 @@
 #ifndef PWM_WORKER_H
 #define PWM_WORKER_H
 
-#include <algorithm>
 #include <stdint.h>
 #include "Serial/config.h"
-#include "SIMD/SIMD.h"
 
-namespace Matrix::Worker {
-    template <typename T> struct PWM_worker {
+namespace Matrix::PWM::Worker {
+    struct PWM_worker {
         public:
             PWM_worker();
+
+            void reset();
             void process_packet(Serial::packet *p);
-            void save_buffer(Matrix::Buffer *p);
+            void save_buffer(Buffer *p);
+            bool process_row();
 
         private:
-            void build_index_table();
-            SIMD::SIMD_QUARTER<T> *get_table(uint16_t v, uint8_t i);
-            void set_pixel(uint8_t x, uint8_t y, uint16_t r0, uint16_t g0, uint16_t b0, uint16_t r1, uint16_t g1, uint16_t b1);
+            static uint16_t get_value(uint16_t v, uint8_t c, const uint8_t *k, uint8_t t);
+            static uint32_t get_hash(uint8_t y, Serial::packet *p);
+            void copy_row(uint8_t y, Buffer *src);
+            void set_table(uint8_t y);
+            void update_statistics();
+            void set_row(uint8_t y, Serial::packet *p);
+            void set_planes(uint8_t y, Serial::packet *p);
+            uint32_t *sort(uint32_t n, uint32_t core);
+
+            // Every channel of every column has a single line where it turns off. (Thermometer code)
+            //  Entry is (value << 16) | (column << 5) | (6 * chain + channel), sorted by value.
+            //      Memory depends on COLUMNS only, not PWM_bits.
+            //      One copy per core. (See process_row)
+            //  HYBRID does not sort. (See set_planes)
+            //  Scratch is static and shares SRAM with the banks and packets. (See Algorithm::scratch_size)
+            constexpr static uint32_t digit_bits = 6;
+            constexpr static uint32_t drop_size = (BCM_bits != 0) ? 1 : (6 * CHAINS * COLUMNS);
+            uint32_t drop[2][drop_size];
+            uint32_t temp[2][drop_size];
+            uint16_t count[2][1 << digit_bits];
 
-            constexpr static uint32_t size = std::max(((1 << PWM_bits) / SIMD::SIMD_QUARTER<T>::size()), (uint32_t) 1);
-            SIMD::SIMD_QUARTER<T> index_table[1 << PWM_bits][6][size];
+            // Rows of every bank are hashed to skip conversion of unchanged rows
+            uint32_t hash[Serial::num_framebuffers][MULTIPLEX];
+            bool valid[Serial::num_framebuffers];
     };
 }
 
@@ -8,6 +8,7 @@
 #define MATRIX_HW_CONFIG_H
 
 #include <stdint.h>
+#include "Matrix/config.h"
 
 namespace Matrix::HUB75 {
     constexpr uint16_t HUB75_DATA_BASE = 8;
@@ -15,8 +16,9 @@ namespace Matrix::HUB75 {
 
     // -- DO NOT EDIT BELOW THIS LINE --
 
-    // Order (LSB to MSB): R0 G0 B0 R1 G1 B1 CLK LAT
-    constexpr uint16_t HUB75_DATA_LEN = 8;
+    // Order (LSB to MSB): R0 G0 B0 R1 G1 B1 (repeated for every chain) CLK LAT
+    constexpr uint16_t HUB75_DATA_LEN = (6 * Matrix::CHAINS) + 2;
+    constexpr uint16_t HUB75_CLK = HUB75_DATA_BASE + (6 * Matrix::CHAINS);
 }
 
 #endif
@@ -0,0 +1,62 @@
+/* 
+ * File:   bitplane.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef MATRIX_BITPLANE_H
+#define MATRIX_BITPLANE_H
+
+#include <stdint.h>
+
+namespace APP {
+    // Transposes an 8x8 bit matrix in each byte lane (Hacker's Delight, transpose8)
+    //  Row k of the matrix is word k, column b is bit b of the lane.
+    //      Input words are channels (R0 G0 B0 R1 G1 B1 and two empty), output words are bitplanes.
+    //  Three rounds of block swaps (4x4, 2x2, 1x1) is 72 operations for 32 bitplane bytes.
+    static inline void transpose(uint32_t *a) {
+        constexpr uint32_t mask[3] = { 0x0F0F0F0F, 0x33333333, 0x55555555 };
+
+        for (uint32_t i = 0, s = 4; i < 3; i++, s >>= 1) {
+            for (uint32_t k = 0; k < 8; k++) {
+                if ((k & s) == 0) {
+                    uint32_t t = ((a[k] >> s) ^ a[k + s]) & mask[i];
+                    a[k] ^= t << s;
+                    a[k + s] ^= t;
+                }
+            }
+        }
+    }
+
+    // Bitplanes of four columns, one column per byte lane (LSB first)
+    //  v holds R0 G0 B0 R1 G1 B1 of every column, bit k of a lane is channel k. (Line layout of HUB75 Buffer.cpp)
+    //  Plane i holds bit i of every channel, each plane is a single word for four columns.
+    //      Replaces 6 * bits lookups per column with ~10 operations per bitplane word.
+    template <uint8_t bits> static inline void get_planes(const uint16_t v[4][6], uint32_t *planes) {
+        static_assert(bits <= 16, "Bitplanes are limited to 16 bits");
+
+        uint32_t lo[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        uint32_t hi[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+        for (uint32_t j = 0; j < 4; j++) {
+            for (uint32_t k = 0; k < 6; k++) {
+                lo[k] |= (v[j][k] & 0xFF) << (j * 8);
+                hi[k] |= (v[j][k] >> 8) << (j * 8);
+            }
+        }
+
+        transpose(lo);
+
+        for (uint32_t i = 0; (i < 8) && (i < bits); i++)
+            planes[i] = lo[i];
+
+        if constexpr (bits > 8) {
+            transpose(hi);
+
+            for (uint32_t i = 8; i < bits; i++)
+                planes[i] = hi[i - 8];
+        }
+    }
+}
+
+#endif
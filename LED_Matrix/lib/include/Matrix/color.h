@@ -0,0 +1,100 @@
+/* 
+ * File:   color.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef MATRIX_COLOR_H
+#define MATRIX_COLOR_H
+
+#include <stdint.h>
+#include <math.h>
+#include <atomic>
+#include "Matrix/config.h"
+#include "Serial/config.h"
+
+namespace APP {
+
+    // Color stage of the workers (Gamma and white balance)
+    //  Serial value of every channel is mapped to a PWM value by a table per channel, this replaces the linear scale.
+    //      Tables are generated at compile time from COLOR_GAMMA and COLOR_BALANCE, with 1.0 the table is the linear scale.
+    //      Host may upload new tables at runtime. (See Serial/Protocol/Serial/Command/Data/Color)
+    //  Two banks, the consumer (worker) only reads the front bank and only swaps between frames.
+    //      Producer writes the back bank and raises pending, consumer swaps and clears pending.
+    //      Producer is refused while pending is raised, the back bank may be taken at any time.
+    //  RGB48 has too many values for a table and keeps the linear scale. (Host does the color mapping)
+    //  Values carry COLOR_DITHER fraction bits below the PWM bits, these are removed by the dither stage. (See Matrix/dither.h)
+    template <uint8_t bits> class Color {
+        public:
+            static constexpr uint32_t size = (Serial::range_high <= 256) ? Serial::range_high : 0;
+            static constexpr uint8_t frac = Matrix::COLOR_DITHER;
+            static constexpr uint16_t max = (1 << (bits + frac)) - 1;
+
+            static_assert(Matrix::COLOR_GAMMA > 0, "COLOR_GAMMA must be positive");
+            static_assert((Matrix::COLOR_BALANCE[0] >= 0) && (Matrix::COLOR_BALANCE[1] >= 0) && (Matrix::COLOR_BALANCE[2] >= 0), "COLOR balance must not be negative");
+            static_assert((bits + frac) <= 16, "PWM bits plus COLOR_DITHER must fit in 16 bits");
+
+            constexpr Color() : table{}, front(0) {
+                for (uint32_t c = 0; c < 3; c++) {
+                    for (uint32_t v = 0; v < size; v++) {
+                        table[0][c][v] = generate(c, v);
+                        table[1][c][v] = table[0][c][v];
+                    }
+                }
+            }
+
+            // Consumer (Called before the rows of a frame are handed out)
+            //  Returns true if the tables changed, every converted row is stale.
+            bool update() {
+                if (!pending.load(std::memory_order_acquire))
+                    return false;
+
+                front ^= 1;
+                pending.store(false, std::memory_order_release);
+                return true;
+            }
+
+            // Consumer
+            inline uint16_t get(uint8_t c, uint16_t v) const {
+                if constexpr (size != 0)
+                    return table[front][c][v];
+                else {
+                    constexpr uint32_t div = ((Serial::range_high >> (bits + frac)) > 1) ? (Serial::range_high >> (bits + frac)) : 1;
+                    constexpr uint32_t mul = (((1 << (bits + frac)) / Serial::range_high) > 1) ? ((1 << (bits + frac)) / Serial::range_high) : 1;
+
+                    return v * mul / div;
+                }
+            }
+
+            // Producer (Red, green and blue tables of size values each)
+            //  Values are clamped to the PWM range. (Including the fraction bits)
+            bool load(const uint16_t *src) {
+                if ((size == 0) || pending.load(std::memory_order_acquire))
+                    return false;
+
+                for (uint32_t c = 0; c < 3; c++)
+                    for (uint32_t v = 0; v < size; v++)
+                        table[front ^ 1][c][v] = (src[(c * size) + v] > max) ? max : src[(c * size) + v];
+
+                pending.store(true, std::memory_order_release);
+                return true;
+            }
+
+        private:
+            // Value v of range_high is on for v / range_high of the time with gamma 1.0. (Same as the linear scale)
+            //  Gamma keeps both ends, the top value stays where the linear scale puts it.
+            static constexpr uint16_t generate(uint32_t c, uint32_t v) {
+                const double top = Serial::range_high - 1.0;
+                const double x = pow(v / top, Matrix::COLOR_GAMMA) * top * Matrix::COLOR_BALANCE[c];
+                const double y = floor(((x * (1 << (bits + frac))) / Serial::range_high) + 0.000001);
+
+                return (y > max) ? max : (uint16_t) y;
+            }
+
+            uint16_t table[2][3][size ? size : 1];
+            uint8_t front;                              // Written by consumer
+            std::atomic<bool> pending = {false};        // Raised by producer, cleared by consumer
+    };
+}
+
+#endif
@@ -0,0 +1,53 @@
+/* 
+ * File:   dither.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef MATRIX_DITHER_H
+#define MATRIX_DITHER_H
+
+#include <stdint.h>
+#include "Matrix/config.h"
+
+namespace APP {
+
+    // Dither stage of the workers (Ordered, 4x4 Bayer)
+    //  Color stage keeps COLOR_DITHER fraction bits below the PWM bits. (See Matrix/color.h)
+    //      Threshold of the shift position is added before the fraction is dropped.
+    //      Fraction f of 2^COLOR_DITHER rounds up on f of every 2^COLOR_DITHER neighbouring pixels.
+    //  Pattern is fixed in time, the worker does not convert rows that did not change.
+    //      Refresh reuses the same buffer and frames may be skipped, the pattern would freeze.
+    //  With COLOR_DITHER 0 this is removed.
+    template <uint8_t bits> class Dither {
+        public:
+            static constexpr uint8_t frac = Matrix::COLOR_DITHER;
+            static constexpr uint16_t max = (1 << bits) - 1;
+
+            static_assert(frac <= 4, "COLOR_DITHER must be 4 or less (4x4 Bayer)");
+
+            // Threshold of shift position (r, x)
+            static inline uint8_t get(uint16_t r, uint16_t x) {
+                return bayer[r % 4][x % 4] >> (4 - frac);
+            }
+
+            static inline uint16_t apply(uint16_t v, uint8_t t) {
+                if constexpr (frac == 0)
+                    return v;
+                else {
+                    v = (v + t) >> frac;
+                    return (v > max) ? max : v;
+                }
+            }
+
+        private:
+            static constexpr uint8_t bayer[4][4] = {
+                {  0,  8,  2, 10 },
+                { 12,  4, 14,  6 },
+                {  3, 11,  1,  9 },
+                { 15,  7, 13,  5 }
+            };
+    };
+}
+
+#endif
@@ -0,0 +1,113 @@
+/* 
+ * File:   dot.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef MATRIX_DOT_H
+#define MATRIX_DOT_H
+
+#include <stdint.h>
+#include <atomic>
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "hardware/watchdog.h"
+#include "Matrix/config.h"
+#include "Matrix/helper.h"
+
+namespace APP {
+
+    // Dot correction of the workers
+    //  Every channel of every pixel has a coefficient k, the PWM value is scaled by (k + 1) / 256. (255 is no correction)
+    //      Table is indexed like the logical image, red, green and blue of every pixel. (See Matrix/map.h)
+    //      Table lives in the last sectors of flash and is read through XIP in row order, it does not cost SRAM.
+    //          Erased flash reads 0xFF, a fresh board has no correction. Firmware updates do not touch it.
+    //  Host reprograms the table one flash page at a time. (See Serial/Protocol/Serial/Command/Data/Dot)
+    //      Flash can not be read while it is written, core 1 is parked in SRAM with interrupts off for every page.
+    //          Display holds the current row with OE off. (DMA_SCAN keeps scanning the displayed frame.)
+    //      Worker sees the new generation before the next frame and converts every row again.
+    class Dot {
+        public:
+            static constexpr uint32_t size = 2 * Matrix::MULTIPLEX * Matrix::CHAINS * Matrix::COLUMNS * 3;
+            static constexpr uint32_t pages = (size + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE;
+            static constexpr uint32_t sectors = (size + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE;
+            static constexpr uint32_t offset = PICO_FLASH_SIZE_BYTES - (sectors * FLASH_SECTOR_SIZE);
+            static constexpr uint32_t watchdog_ms = 500;                    // Sector erase is up to 400ms (See main.cpp)
+
+            // Coefficients of red, green and blue of logical pixel i (See Matrix/map.h)
+            static inline const uint8_t *get(uint32_t i) {
+                return ((const uint8_t *) (XIP_BASE + offset)) + (i * 3);
+            }
+
+            static inline uint16_t apply(uint16_t v, uint8_t k) {
+                return (v * (k + 1)) >> 8;
+            }
+
+            // Consumer (Called before the rows of a frame are handed out)
+            //  Returns true if the table changed, every converted row is stale.
+            static inline bool update() {
+                static uint32_t seen = 0;
+                const uint32_t g = generation.load(std::memory_order_acquire);
+
+                if (g == seen)
+                    return false;
+
+                seen = g;
+                return true;
+            }
+
+            // Consumer (Called by the worker between frames)
+            static inline void __not_in_flash_func(poll)() {
+                if (state.load(std::memory_order_acquire) == REQUEST) {
+                    uint32_t irq = save_and_disable_interrupts();
+
+                    state.store(PARKED, std::memory_order_release);
+                    __sev();
+
+                    while (state.load(std::memory_order_acquire) != RUN)
+                        __wfe();
+
+                    restore_interrupts(irq);
+                }
+            }
+
+            // Producer (Core 0, page of FLASH_PAGE_SIZE bytes in SRAM)
+            //  Blocks until the page is written, the first page of a sector erases it.
+            //      Worker finishes the frame it is converting before it parks. (See poll)
+            static inline void __not_in_flash_func(program)(uint32_t page, const uint8_t *data) {
+                const uint32_t address = offset + (page * FLASH_PAGE_SIZE);
+
+                state.store(REQUEST, std::memory_order_release);
+                multicore_fifo_doorbell_inline(0);
+
+                while (state.load(std::memory_order_acquire) != PARKED)
+                    watchdog_update();
+
+                watchdog_enable(watchdog_ms, false);
+                uint32_t irq = save_and_disable_interrupts();
+
+                if ((address % FLASH_SECTOR_SIZE) == 0)
+                    flash_range_erase(address, FLASH_SECTOR_SIZE);
+
+                flash_range_program(address, data, FLASH_PAGE_SIZE);
+                restore_interrupts(irq);
+                watchdog_enable(1, false);
+
+                generation.store(generation.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+                state.store(RUN, std::memory_order_release);
+                __sev();
+            }
+
+        private:
+            static constexpr uint32_t RUN = 0;
+            static constexpr uint32_t REQUEST = 1;
+            static constexpr uint32_t PARKED = 2;
+
+            static inline std::atomic<uint32_t> state = {RUN};              // Written by both cores, one at a time
+            static inline std::atomic<uint32_t> generation = {0};           // Written by producer
+
+            static_assert(offset >= (512 * 1024), "Dot correction table leaves less than 512KB of flash for the firmware");
+    };
+}
+
+#endif
@@ -0,0 +1,310 @@
+/* 
+ * File:   engine.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef MATRIX_ENGINE_H
+#define MATRIX_ENGINE_H
+
+#include <stdint.h>
+#include "pico/multicore.h"
+#include "hardware/timer.h"
+#include "Serial/config.h"
+#include "Matrix/config.h"
+#include "Matrix/matrix.h"
+#include "Matrix/helper.h"
+#include "Matrix/queue.h"
+#include "Matrix/color.h"
+#include "Matrix/dot.h"
+#include "Multiplex/Multiplex.h"
+
+namespace Matrix {
+    /**
+     *  @brief Frame boundary of the displayed algorithm
+     *  @details Called from the ISR which took the next bank, the panel is off and row 0 is about to be selected.
+     *  @details Implemented in Matrix/engine_api.h
+     */
+    void frame();
+}
+
+namespace Matrix::Worker {
+    // Counters of every algorithm of the engine (See get_statistics)
+    inline volatile Statistics stats;
+
+    // Color stage (See Matrix/color.h)
+    //  PWM_bits is derived from the same options by every memory format, the algorithms of an engine share the tables.
+    template <uint8_t bits> inline APP::Color<bits> color;
+}
+
+namespace Matrix {
+    // Matrix engine
+    //  Algorithms are linked into one image, each brings its display and its worker. (See <FAMILY>/<ALG>/algorithm.h)
+    //      One algorithm is the firmware as before, the API calls it directly.
+    //      HUB75 ENGINE links PWM and BCM: BCM for static content with depth, PWM for video. (See HUB75/ENGINE/engine.cpp)
+    //  Algorithms are a table built at compile time, nothing tests for the algorithm in the ISRs or the worker loop.
+    //      ISRs call the displayed algorithm, the worker and core 0 call the target algorithm.
+    //      Hooks are function pointers which do nothing until a switch is armed.
+    //  Profiles of the engine follow each other by algorithm. (See set_profile)
+    //
+    //  Switch (Worker and ISRs share core 1, see main.cpp)
+    //      Worker converts the newest frame into the banks of the target, the displayed algorithm keeps repeating its own.
+    //          Packet of the newest frame is still intact if nothing newer was queued. (See last)
+    //      Worker arms the frame hook, the displayed algorithm calls it at its next frame boundary. (See frame)
+    //      Frame hook arms the tail hook, which runs at the end of that ISR:
+    //          Displayed algorithm gives back its state machines, programs and DMA channels. (Row 0 is selected, panel is off)
+    //          Target loads its programs and starts row 0 of its front bank with the blank time.
+    //      Refresh across the switch is the last one of the displayed algorithm and the blank time of the target, none is dropped. (Rows stay in order)
+    //  Every algorithm has its own banks, SRAM holds the banks of every algorithm.
+    template <typename... Algorithms> class Engine {
+        public:
+            // Once, from core 1 before the ISRs are enabled (See main.cpp)
+            static void start() {
+                timer = hardware_alarm_claim_unused(true);
+                timer_hw->inte |= 1 << timer;
+
+                Multiplex::init(MULTIPLEX);
+                (Algorithms::init(), ...);
+                shown->resume();
+            }
+
+            static void dma_isr() {
+                if constexpr (count == 1)
+                    (Algorithms::dma_isr(), ...);
+                else {
+                    shown->dma_isr();
+                    tail_hook();
+                }
+            }
+
+            static void pio_isr() {
+                if constexpr (count == 1)
+                    (Algorithms::pio_isr(), ...);
+                else {
+                    shown->pio_isr();
+                    tail_hook();
+                }
+            }
+
+            static void timer_isr() {
+                if constexpr (count == 1)
+                    (Algorithms::timer_isr(), ...);
+                else {
+                    shown->timer_isr();
+                    tail_hook();
+                }
+            }
+
+            static void frame() {
+                if constexpr (count > 1)
+                    frame_hook();
+            }
+
+            // Profile p belongs to the algorithm whose profiles cover it, counted from the profiles of the algorithms before it.
+            //  Profile of the displayed algorithm takes effect with the next refresh. (See the algorithm)
+            //  Profile of another algorithm is set in that algorithm, the worker switches at the next frame boundary.
+            static bool set_profile(uint8_t p) {
+                for (uint8_t i = 0; i < count; i++) {
+                    const uint8_t n = algorithms[i].get_profiles();
+
+                    if (p < n) {
+                        if (!algorithms[i].set_profile(p))
+                            return false;
+
+                        if (i != requested) {
+                            requested = i;
+                            APP::multicore_fifo_doorbell_inline(0);
+                        }
+
+                        return true;
+                    }
+
+                    p -= n;
+                }
+
+                return false;
+            }
+
+            static void work() {
+                // Worker is shared with core 0 from here on (See assist)
+                (Algorithms::start(), ...);
+
+                while (1) {
+                    APP::multicore_fifo_pop_blocking_inline();     // Doorbell
+                    APP::multicore_fifo_drain_inline();
+                    poll();
+                }
+            }
+
+            // Worker loop after a doorbell
+            static void poll() {
+                descriptor d;
+
+                if constexpr (count > 1) {
+                    if (requested != index)
+                        retarget();
+                }
+
+                // Only the newest frame is converted, older frames are coalesced. (Latest frame wins)
+                while (queue.front(&d))
+                    convert(d);
+
+                // Dot correction table is written between frames (See Matrix/dot.h)
+                APP::Dot::poll();
+            }
+
+            // Converts at most one row per call, this bounds the polling latency of core 0.
+            static void assist() {
+                target->assist();
+            }
+
+            // Never blocks, a full ring rejects the frame. (See Statistics::frames_rejected)
+            //  Rejected buffer stays with the caller.
+            static bool process(Serial::packet *buffer) {
+                if (!queue.push({descriptor::TYPE::PACKET, buffer}))
+                    return false;
+
+                APP::multicore_fifo_doorbell_inline(0);
+                return true;
+            }
+
+            static bool process(Buffer *buffer) {
+                if (!queue.push({descriptor::TYPE::BUFFER, buffer}))
+                    return false;
+
+                APP::multicore_fifo_doorbell_inline(0);
+                return true;
+            }
+
+            // Tables are taken before the next frame is converted. (See Matrix/color.h)
+            static bool set_color(const uint16_t *table) {
+                return target->set_color(table);
+            }
+
+            // Worker is parked between frames while the page is written. (See Matrix/dot.h)
+            static bool set_dot(uint16_t page, const uint8_t *data) {
+                if (page >= APP::Dot::pages)
+                    return false;
+
+                APP::Dot::program(page, data);
+                return true;
+            }
+
+            static const volatile Worker::Statistics *get_statistics() {
+                return &Worker::stats;
+            }
+
+        private:
+            struct algorithm_t {
+                void (*resume)();
+                void (*dma_isr)();
+                void (*pio_isr)();
+                void (*timer_isr)();
+                bool (*set_profile)(uint8_t);
+                uint8_t (*get_profiles)();
+                void (*reset)();
+                void (*process_packet)(Serial::packet *);
+                void (*save_buffer)(Buffer *);
+                void (*assist)();
+                bool (*set_color)(const uint16_t *);
+            };
+
+            // Work handed from core 0 to core 1 (See process)
+            //  Ring owns the accepted packets until they are converted or coalesced, the one being converted included.
+            //      Data node only moves on to its next packet buffer once a packet is accepted. (See Serial::Node::Data::commit)
+            //      Its rotation comes back to a buffer num_packets accepts later, by then the ring has let go of it.
+            //  FIFO only carries doorbells.
+            struct descriptor {
+                enum class TYPE : uint32_t { PACKET, BUFFER } type;
+                void *ptr;
+            };
+
+            static constexpr uint8_t count = sizeof...(Algorithms);
+
+            static void idle() {
+                // Nothing armed
+            }
+
+            // Table is in SRAM, the ISRs do not wait on flash.
+            static inline algorithm_t algorithms[count] = {
+                { Algorithms::resume, Algorithms::dma_isr, Algorithms::pio_isr, Algorithms::timer_isr, Algorithms::set_profile, Algorithms::get_profiles,
+                    Algorithms::reset, Algorithms::process_packet, Algorithms::save_buffer, Algorithms::assist, Algorithms::set_color }...
+            };
+            static inline APP::Ring<descriptor, Serial::num_packets - 2> queue;
+
+            static inline const algorithm_t *volatile shown = &algorithms[0];      // Displayed (ISRs)
+            static inline const algorithm_t *volatile target = &algorithms[0];     // Converted into (Worker and core 0)
+            static inline const algorithm_t *volatile next = &algorithms[0];       // Displayed after the switch
+            static inline volatile uint8_t requested = 0;                           // Written by set_profile (Core 0)
+            static inline uint8_t index = 0;                                        // Algorithm of target (Worker)
+            static inline Serial::packet *last = nullptr;                           // Packet of the newest frame converted
+            static inline void (*volatile frame_hook)() = idle;
+            static inline void (*volatile tail_hook)() = idle;
+
+            // Packets are shared, every algorithm has its own banks and worker scratch.
+            //  Stacks and the rest of the firmware are given sram_reserved.
+            static constexpr uint32_t sram_size = 264 * 1024;
+            static constexpr uint32_t sram_reserved = 64 * 1024;
+            static_assert(((count * Serial::num_framebuffers * Serial::max_framebuffer_size) + (Algorithms::scratch_size + ...) + (Serial::num_packets * sizeof(Serial::packet))) <= (sram_size - sram_reserved),
+                "Banks and worker scratch of every algorithm do not fit in SRAM, reduce COLUMNS, MULTIPLEX or CHAINS");
+
+            static void convert(const descriptor &d) {
+                switch (d.type) {
+                    case descriptor::TYPE::PACKET:
+                        last = (Serial::packet *) d.ptr;
+                        target->process_packet(last);
+                        break;
+                    case descriptor::TYPE::BUFFER:
+                        last = nullptr;                                             // Buffer is in the format of one algorithm only
+                        target->save_buffer((Buffer *) d.ptr);
+                        break;
+                    default:
+                        break;
+                }
+
+                queue.pop();
+                Worker::stats.frames_coalesced = queue.get_coalesced();
+                Worker::stats.frames_rejected = queue.get_rejected();
+                Worker::stats.queue_depth_max = queue.get_depth_max();
+            }
+
+            // Worker side of a switch
+            //  Banks of the target were not displayed in between, they are converted again from the newest frame.
+            //      Without a packet the target shows its last bank until the next frame.
+            static void retarget() {
+                descriptor d;
+
+                index = requested;
+                target = &algorithms[index];
+                target->reset();
+
+                if (queue.front(&d))
+                    convert(d);
+                else if (last != nullptr)
+                    target->process_packet(last);
+
+                next = target;
+                frame_hook = arm;
+            }
+
+            // Frame boundary of the displayed algorithm, the switch waits for the end of its ISR.
+            static void arm() {
+                frame_hook = idle;
+                tail_hook = handover;
+            }
+
+            static void handover() {
+                static void (*const suspend[count])() = { Algorithms::suspend... };
+
+                tail_hook = idle;
+
+                if (next != shown) {
+                    suspend[shown - algorithms]();
+                    shown = next;
+                    shown->resume();
+                }
+            }
+    };
+}
+
+#endif
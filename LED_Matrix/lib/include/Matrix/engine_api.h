@@ -0,0 +1,76 @@
+/* 
+ * File:   engine_api.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef MATRIX_ENGINE_API_H
+#define MATRIX_ENGINE_API_H
+
+// API of Matrix/matrix.h for the engine of the firmware (See Matrix/engine.h)
+//  Definitions, included once by the engine.cpp of the algorithm folder after it names the engine Matrix::engine.
+#include <stdint.h>
+#include "pico/platform.h"
+#include "Serial/config.h"
+#include "Matrix/matrix.h"
+#include "Matrix/engine.h"
+
+namespace Matrix {
+    volatile int timer;
+
+    void start() {
+        engine::start();
+    }
+
+    void __not_in_flash_func(dma_isr)() {
+        engine::dma_isr();
+    }
+
+    void __not_in_flash_func(pio_isr)() {
+        engine::pio_isr();
+    }
+
+    void __not_in_flash_func(timer_isr)() {
+        engine::timer_isr();
+    }
+
+    void __not_in_flash_func(frame)() {
+        engine::frame();
+    }
+
+    bool set_profile(uint8_t profile) {
+        return engine::set_profile(profile);
+    }
+}
+
+namespace Matrix::Worker {
+    void work() {
+        engine::work();
+    }
+
+    void __not_in_flash_func(assist)() {
+        engine::assist();
+    }
+
+    bool __not_in_flash_func(process)(Serial::packet *buffer) {
+        return engine::process(buffer);
+    }
+
+    bool __not_in_flash_func(process)(Matrix::Buffer *buffer) {
+        return engine::process(buffer);
+    }
+
+    bool set_color(const uint16_t *table) {
+        return engine::set_color(table);
+    }
+
+    bool set_dot(uint16_t page, const uint8_t *data) {
+        return engine::set_dot(page, data);
+    }
+
+    const volatile Statistics *get_statistics() {
+        return engine::get_statistics();
+    }
+}
+
+#endif
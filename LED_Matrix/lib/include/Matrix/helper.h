@@ -38,6 +38,22 @@ namespace APP {
         // Fire off an event to the other core
         __sev();
     }
+
+    // Non-blocking push, used as a doorbell for shared memory (See Matrix/queue.h)
+    //  If the FIFO is full the other core has not read the earlier doorbells yet and will still wake up.
+    static inline void __not_in_flash_func(multicore_fifo_doorbell_inline)(uint32_t data) {
+        if (multicore_fifo_wready())
+            sio_hw->fifo_wr = data;
+
+        // Fire off an event to the other core
+        __sev();
+    }
+
+    // Drops every pending doorbell
+    static inline void __not_in_flash_func(multicore_fifo_drain_inline)(void) {
+        while (multicore_fifo_rvalid())
+            (void) sio_hw->fifo_rd;
+    }
 }
 
 #endif
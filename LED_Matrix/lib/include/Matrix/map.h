@@ -0,0 +1,125 @@
+/* 
+ * File:   map.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef MATRIX_MAP_H
+#define MATRIX_MAP_H
+
+#include <stdint.h>
+#include "Matrix/config.h"
+#include "Serial/config.h"
+
+namespace APP {
+
+    // Pixel mapping of the workers
+    //  Host sends the logical image, the worker gathers the pixel of every shift position from it.
+    //      Index of every shift position is generated at compile time from the PIXEL_ settings.
+    //      Gather is done by the row conversion itself, there is no extra pass over the packet.
+    //  Shift position (r, x) is row r and column x of Serial::packet::data. (Shift order, chains are stacked)
+    //      Layout places it on the panel, then the panel is mirrored and rotated into the logical image.
+    //  Logical image is width by height pixels, stored row by row in the packet. (Same size as the shift order)
+    //  Linear layout without rotation or mirror is the shift order, the table is removed.
+    class Map {
+        public:
+            static constexpr uint32_t rows = 2 * Matrix::MULTIPLEX * Matrix::CHAINS;
+            static constexpr uint8_t fold = (Matrix::PIXEL_LAYOUT != 0) ? Matrix::PIXEL_FOLD : 1;
+
+            // Panel (all chains) as seen from the front
+            static constexpr uint32_t panel_width = Matrix::COLUMNS / fold;
+            static constexpr uint32_t panel_height = rows * fold;
+
+            // Logical image sent by the host
+            static constexpr bool swap = (Matrix::PIXEL_ROTATION == 90) || (Matrix::PIXEL_ROTATION == 270);
+            static constexpr uint32_t width = swap ? panel_height : panel_width;
+            static constexpr uint32_t height = swap ? panel_width : panel_height;
+
+            static constexpr bool identity = (fold == 1) && (Matrix::PIXEL_ROTATION == 0) && (Matrix::PIXEL_MIRROR == 0);
+
+            static_assert(Matrix::PIXEL_LAYOUT <= 2, "Unsupported PIXEL_LAYOUT");
+            static_assert(Matrix::PIXEL_FOLD >= 1, "PIXEL_FOLD must be at least 1");
+            static_assert((fold == 1) || ((Matrix::COLUMNS % (Matrix::PIXEL_BLOCK * fold)) == 0), "COLUMNS must be a multiple of PIXEL_BLOCK * PIXEL_FOLD");
+            static_assert((Matrix::PIXEL_ROTATION % 90) == 0 && Matrix::PIXEL_ROTATION < 360, "PIXEL_ROTATION must be 0, 90, 180 or 270");
+            static_assert(Matrix::PIXEL_MIRROR <= 3, "Unsupported PIXEL_MIRROR");
+            static_assert((rows * Matrix::COLUMNS) <= 65536, "Pixel map index does not fit in 16 bits");
+
+            // Index of the logical pixel shifted at (r, x)
+            static inline uint32_t get(uint16_t r, uint16_t x) {
+                if constexpr (identity)
+                    return (r * Matrix::COLUMNS) + x;
+                else
+                    return table.index[r][x];
+            }
+
+            static inline const Serial::pixel *pixel(const Serial::packet *p, uint32_t i) {
+                return &p->data[0][0] + i;
+            }
+
+        private:
+            struct Table {
+                uint16_t index[identity ? 1 : rows][identity ? 1 : Matrix::COLUMNS];
+            };
+
+            // Layouts:
+            //  0: Linear, every scan row drives one panel row per half. (Shift order)
+            //  1: Stripe, every scan row drives PIXEL_FOLD panel rows per half, MULTIPLEX rows apart.
+            //      Shift chain fills PIXEL_BLOCK columns of every panel row, bottom row first, then moves right.
+            //  2: Zig-zag, same as stripe but every other group of blocks goes top row first.
+            static constexpr uint32_t generate(uint32_t r, uint32_t x) {
+                const uint32_t chain = r / (2 * Matrix::MULTIPLEX);
+                const uint32_t half = (r / Matrix::MULTIPLEX) % 2;
+                const uint32_t scan = r % Matrix::MULTIPLEX;
+                uint32_t f = 0;
+                uint32_t px = x;
+
+                if (fold != 1) {
+                    const uint32_t b = x / Matrix::PIXEL_BLOCK;
+                    const uint32_t g = b / fold;
+                    const uint32_t j = b % fold;
+
+                    f = ((Matrix::PIXEL_LAYOUT == 2) && (g % 2)) ? j : (fold - 1 - j);
+                    px = (g * Matrix::PIXEL_BLOCK) + (x % Matrix::PIXEL_BLOCK);
+                }
+
+                uint32_t py = (chain * 2 * Matrix::MULTIPLEX * fold) + (half * Matrix::MULTIPLEX * fold) + (f * Matrix::MULTIPLEX) + scan;
+
+                if (Matrix::PIXEL_MIRROR & 1)
+                    px = panel_width - 1 - px;
+
+                if (Matrix::PIXEL_MIRROR & 2)
+                    py = panel_height - 1 - py;
+
+                // Panel shows the logical image rotated clockwise
+                switch (Matrix::PIXEL_ROTATION) {
+                    case 90:
+                        return ((panel_width - 1 - px) * width) + py;
+                    case 180:
+                        return ((panel_height - 1 - py) * width) + (panel_width - 1 - px);
+                    case 270:
+                        return (px * width) + (panel_height - 1 - py);
+                    default:
+                        return (py * width) + px;
+                }
+            }
+
+            static constexpr Table build() {
+                Table t = {};
+
+                if (!identity) {
+                    for (uint32_t r = 0; r < rows; r++)
+                        for (uint32_t x = 0; x < Matrix::COLUMNS; x++)
+                            t.index[r][x] = generate(r, x);
+                }
+
+                return t;
+            }
+
+            static const Table table;
+    };
+
+    // Flash (Read through XIP)
+    inline constexpr Map::Table Map::table = Map::build();
+}
+
+#endif
@@ -0,0 +1,80 @@
+/* 
+ * File:   queue.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef MATRIX_QUEUE_H
+#define MATRIX_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+namespace APP {
+
+    // Single producer, single consumer ring in SRAM
+    //  Producer only writes head, consumer only writes tail. (No locks)
+    //      Cortex-M0+ has no exclusive load/store, only atomic loads and stores of words are used.
+    //      Head and tail live in separate words, neither side writes a word the other side writes.
+    //  Consumer always takes the newest entry, older entries are coalesced (dropped).
+    //      Entry taken stays owned by the consumer until pop, the producer will not reuse its slot.
+    //  Producer never blocks, a full ring rejects the entry.
+    template <typename T, uint32_t N> class Ring {
+        public:
+            static_assert((N != 0) && ((N & (N - 1)) == 0), "Ring size must be a power of two");
+
+            // Producer
+            bool push(const T &v) {
+                const uint32_t h = head.load(std::memory_order_relaxed);
+
+                if ((h - tail.load(std::memory_order_acquire)) >= N) {
+                    rejected.store(rejected.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                items[h % N] = v;
+                head.store(h + 1, std::memory_order_release);
+                return true;
+            }
+
+            // Consumer (Skips to the newest entry)
+            bool front(T *v) {
+                const uint32_t h = head.load(std::memory_order_acquire);
+                const uint32_t t = tail.load(std::memory_order_relaxed);
+
+                if (h == t)
+                    return false;
+
+                if ((h - t) > depth_max)
+                    depth_max = h - t;
+
+                coalesced += h - t - 1;
+                tail.store(h - 1, std::memory_order_release);
+                *v = items[(h - 1) % N];
+                return true;
+            }
+
+            // Consumer (Releases the entry taken by front)
+            void pop() {
+                tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+
+            uint32_t depth() const {
+                return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+            }
+
+            uint32_t get_rejected() const { return rejected.load(std::memory_order_relaxed); }
+            uint32_t get_coalesced() const { return coalesced; }
+            uint32_t get_depth_max() const { return depth_max; }
+
+        private:
+            T items[N];
+            std::atomic<uint32_t> head = {0};
+            std::atomic<uint32_t> tail = {0};
+            std::atomic<uint32_t> rejected = {0};   // Written by producer
+            uint32_t coalesced = 0;                 // Written by consumer
+            uint32_t depth_max = 0;                 // Written by consumer
+    };
+}
+
+#endif
@@ -7,6 +7,8 @@
 #ifndef MULTIPLEX_H
 #define MULTIPLEX_H
 
+#include <stdint.h>
+
 namespace Multiplex {
     /**
      *  @brief Initialize multiplexer state machine
@@ -19,6 +21,20 @@ namespace Multiplex {
      *  @details Implemented in Multiplex/<name>/<name>.cpp
      */
     void SetRow(int row);
+
+    /**
+     *  @brief Address pin levels of a row, used by DMA scanning
+     *  @details Implemented in Multiplex/<name>/<name>.cpp
+     *  @details Mask of the address pins which are high. Returns false if rows are not static pin levels.
+     */
+    bool GetRowPins(int row, uint32_t *pins);
+
+    /**
+     *  @brief Row word of the shifter state machine, used by DMA scanning
+     *  @details Implemented in Multiplex/<name>/<name>.cpp
+     *  @details Writing the word into fifo selects the row. Returns false if rows are not shifted by a state machine.
+     */
+    bool GetRowWord(int row, uint32_t *word, volatile uint32_t **fifo);
 }
     
 #endif
@@ -12,6 +12,7 @@
 
 namespace Serial::Node::Data {
     void callback(Serial::packet **buf);
+    void commit(Serial::packet *buf);
     uint16_t get_len();
     bool isAvailable();
     uint8_t getc();
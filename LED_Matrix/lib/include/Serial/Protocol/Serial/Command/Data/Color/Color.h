@@ -0,0 +1,28 @@
+/* 
+ * File:   Color.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+ 
+#ifndef SERIAL_PROTOCOL_SERIAL_COMMAND_DATA_COLOR_H
+#define SERIAL_PROTOCOL_SERIAL_COMMAND_DATA_COLOR_H
+
+#include "Serial/Protocol/Serial/Command/Command.h"
+
+namespace Serial::Protocol::DATA_NODE {
+    class Color : public Command {
+        public:
+            // Red, green and blue tables of range_high values each (RGB48 has no tables)
+            static constexpr uint16_t size = 3 * ((Serial::range_high <= 256) ? Serial::range_high : 0);
+
+        protected:
+            void process_frame_internal();
+            void process_command_internal();
+            void process_payload_internal();
+            void process_internal(Serial::packet *buf, uint16_t len);
+
+            static uint16_t table[size ? size : 1];
+    };
+}
+
+#endif
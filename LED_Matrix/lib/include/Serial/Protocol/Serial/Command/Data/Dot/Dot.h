@@ -0,0 +1,30 @@
+/* 
+ * File:   Dot.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+ 
+#ifndef SERIAL_PROTOCOL_SERIAL_COMMAND_DATA_DOT_H
+#define SERIAL_PROTOCOL_SERIAL_COMMAND_DATA_DOT_H
+
+#include "hardware/flash.h"
+#include "Serial/Protocol/Serial/Command/Command.h"
+
+namespace Serial::Protocol::DATA_NODE {
+    class Dot : public Command {
+        public:
+            // One flash page of the dot correction table, the page number is in the header (See Matrix/dot.h)
+            static constexpr uint16_t size = FLASH_PAGE_SIZE;
+
+        protected:
+            void process_frame_internal();
+            void process_command_internal();
+            void process_payload_internal();
+            void process_internal(Serial::packet *buf, uint16_t len);
+
+            static uint8_t page[size];
+            static uint16_t num;
+    };
+}
+
+#endif
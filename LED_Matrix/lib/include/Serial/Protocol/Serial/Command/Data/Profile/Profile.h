@@ -0,0 +1,24 @@
+/* 
+ * File:   Profile.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+ 
+#ifndef SERIAL_PROTOCOL_SERIAL_COMMAND_DATA_PROFILE_H
+#define SERIAL_PROTOCOL_SERIAL_COMMAND_DATA_PROFILE_H
+
+#include "Serial/Protocol/Serial/Command/Command.h"
+
+namespace Serial::Protocol::DATA_NODE {
+    class Profile : public Command {
+        protected:
+            void process_frame_internal();
+            void process_command_internal();
+            void process_payload_internal();
+            void process_internal(Serial::packet *buf, uint16_t len);
+
+            static uint8_t profile;
+    };
+}
+
+#endif
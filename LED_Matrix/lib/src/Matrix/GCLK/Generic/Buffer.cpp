@@ -0,0 +1,78 @@
+/* 
+ * File:   Buffer.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <string.h>
+#include "pico/multicore.h"
+#include "Matrix/GCLK/Generic/algorithm.h"
+#include "Matrix/GCLK/Generic/memory_format.h"
+
+// Bank is one DMA stream, VSYNC command followed by a data block per channel of every row.
+//  Every block starts with the program address word and counter words indexed from zero.
+//  Data block has PWM_bits elements per driver, bit PWM_bits - 1 first.
+//      Every element is a line_t holding all chains.
+//  Lines of this Buffer are the data blocks, index selects the channel.
+
+namespace Matrix::BCM {
+    constexpr uint32_t column_offset = 8;
+
+    Buffer::Buffer() {
+        memset(buf, 0, sizeof(buf));
+
+        // VSYNC command (Elements are zero)
+        uint32_t *p = (uint32_t *) buf;
+        p[0] = command_pc;
+        p[1] = command_elements(GCLK::GCLK_LE_VSYNC) - GCLK::GCLK_LE_VSYNC - 1;
+        p[2] = GCLK::GCLK_LE_VSYNC - 1;
+
+        // Fill in program address and counter variable
+        for (uint8_t y = 0; y < MULTIPLEX; y++) {
+            for (uint16_t i = 0; i < GCLK::GCLK_CHANNELS; i++) {
+                p = (uint32_t *) get_line(y, i);
+                p[0] = data_pc;
+                p[1] = drivers - 1;
+            }
+        }
+    }
+
+    // Chains share an element, the other chains must be preserved.
+    static inline void set_element(line_t *element, uint8_t chain, uint8_t value) {
+        if constexpr (CHAINS == 1)
+            *element = value;
+        else
+            *element = (*element & ~(0x3F << (6 * chain))) | (value << (6 * chain));
+    }
+
+    // Index is the bitplane of the value
+    void Buffer::set_value(uint8_t multiplex, uint16_t index, uint16_t column, uint8_t chain, uint8_t value) {
+        uint32_t i = vsync_length + (multiplex * row_length);
+        i += (column % GCLK::GCLK_CHANNELS) * group_length;
+        i += column_offset + ((((column / GCLK::GCLK_CHANNELS) * PWM_bits) + (PWM_bits - 1 - index)) * sizeof(line_t));
+
+        set_element((line_t *) &buf[i], chain, value);
+    }
+
+    // Writes four columns, one per byte lane (LSB first)
+    //  Neighbouring columns are different channels, which are in different blocks. This is always done per column.
+    void Buffer::set_word(uint8_t multiplex, uint16_t index, uint16_t column, uint8_t chain, uint32_t value) {
+        for (uint32_t j = 0; j < 4; j++)
+            set_value(multiplex, index, column + j, chain, (value >> (j * 8)) & 0xFF);
+    }
+
+    uint8_t *Buffer::get_line(uint8_t multiplex, uint16_t index) {
+        uint32_t i = vsync_length + (multiplex * row_length);
+        i += index * group_length;
+
+        return &buf[i];
+    }
+
+    uint16_t Buffer::get_line_length() {
+        return group_length;
+    }
+
+    uint8_t Buffer::get_column_offset() {
+        return column_offset;
+    }
+}
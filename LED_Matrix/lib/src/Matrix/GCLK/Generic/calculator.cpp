@@ -0,0 +1,100 @@
+/* 
+ * File:   calculator.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <algorithm>
+#include <stdint.h>
+#include "Matrix/GCLK/Generic/memory_format.h"
+#include "Matrix/GCLK/hw_config.h"
+#include "Matrix/matrix.h"
+#include "Serial/config.h"
+
+namespace Matrix::BCM::Calculator {
+    // Panel constants
+    constexpr double max_clk_mhz = 25.0;
+    constexpr double max_gclk_mhz = 25.0;               // Verify against the datasheet of the driver
+    constexpr uint8_t fanout_per_clk = 6;
+    constexpr uint8_t max_impedance = 50;               // For longer chains may need custom circuit board which adjusts this
+    constexpr uint8_t max_par_cap_pf = 18;              // For longer chains may need custom circuit board which adjusts this
+    constexpr uint8_t min_harmonics = 5;
+
+    // LED constants
+    constexpr uint8_t max_led_cap_pf = 18;
+
+    // Display is off for the blank time of every row. (See matrix.cpp)
+    //  GCLK stops at the end of the row, the CPU switches the row and restarts GCLK after the blank time.
+    static constexpr double get_row_us() {
+        return ((GCLK::GCLK_PER_ROW * 1000000.0) / GRAYSCALE_CLOCK) + BLANK_TIME + 1;
+    }
+
+    static constexpr double get_refresh() {
+        return 1000000.0 / (MULTIPLEX * get_row_us());
+    }
+
+    static constexpr void is_clk_valid() {
+        // DCLK and GCLK are shared by every driver of every chain
+        constexpr uint64_t temp = CHAINS * drivers * (max_impedance * fanout_per_clk * min_harmonics * max_par_cap_pf);
+        constexpr double hz_limit = BYPASS_FANOUT ? max_clk_mhz * 1000000.0 : 
+            std::min(max_clk_mhz, (double) (1000000.0 / (temp * 1.0))) * 1000000.0;
+        constexpr double gclk_hz_limit = BYPASS_FANOUT ? max_gclk_mhz * 1000000.0 : 
+            std::min(max_gclk_mhz, (double) (1000000.0 / (temp * 1.0))) * 1000000.0;
+        constexpr double frame_us = (frame_cycles * 1000000.0) / (2.0 * SERIAL_CLOCK);      // Bank is shifted once per frame
+        constexpr double vsync_us = (command_cycles(GCLK::GCLK_LE_VSYNC) * 1000000.0) / (2.0 * SERIAL_CLOCK);
+
+        static_assert(SERIAL_CLOCK <= hz_limit, "Serial clock is too high");
+        static_assert(GRAYSCALE_CLOCK <= gclk_hz_limit, "Grayscale clock is too high");
+        static_assert(frame_us <= (1000000.0 / FPS), "Serial clock is too low to shift the frames");
+        static_assert(vsync_us <= BLANK_TIME, "VSYNC does not fit in the blank time");
+    }
+
+    static constexpr void is_refresh_valid() {
+        static_assert(MIN_REFRESH <= get_refresh(), "Refresh is too high for the grayscale clock");
+        static_assert((get_refresh() / sub_periods) >= FPS, "Grayscale period is longer than a frame");
+    }
+
+    static constexpr void is_brightness_valid() {
+        constexpr double on_us = (GCLK::GCLK_PER_ROW * 1000000.0) / GRAYSCALE_CLOCK;    // Drivers are off during the blank time
+        constexpr double brightness = on_us / get_row_us();
+
+        static_assert(brightness > 0.75, "Brightness less than 75 percent is not recommended");
+    }
+
+    static constexpr void is_blank_time_valid() {
+        constexpr double led_fall_us_high = (10000 * COLUMNS * max_led_cap_pf) / 1000000.0;
+
+        static_assert(led_fall_us_high < BLANK_TIME, "Blank time is too low for high side");
+    }
+
+    /*  Must test the following:
+     *      1) Fanout
+     *      2) Refresh
+     *      3) Memory usage
+     *      4) Computation operations required
+     *  Additional Tests:
+     *      1) Grayscale limits
+     *      2) Ghosting limits
+     *      3) Accuracy of signals
+     */
+    void verify_configuration() {
+        is_brightness_valid();
+        is_clk_valid();
+        is_refresh_valid();
+        is_blank_time_valid();
+
+        static_assert((COLUMNS % GCLK::GCLK_CHANNELS) == 0, "COLUMNS must be a multiple of the driver channels");
+        static_assert(COLUMNS <= 1024, "COLUMNS more than 1024 is not recommended");
+        static_assert(PWM_bits >= 2, "Grayscale less than 2 bits is not supported");
+        static_assert(PWM_bits <= (GCLK::GCLK_CHANNEL_BITS - 2), "Grayscale more than 14 bits is not supported");
+        static_assert(GCLK::GCLK_PER_ROW >= 2, "GCLK_PER_ROW must be at least two");
+        static_assert((group_length % 4) == 0, "Data blocks must be whole words");
+        static_assert((2 * MULTIPLEX * COLUMNS * CHAINS) <= 8192, "More than 8192 pixels is not recommended");
+        static_assert((2 * MULTIPLEX * COLUMNS * CHAINS * sizeof(Serial::DEFINE_SERIAL_RGB_TYPE)) <= Serial::payload_size, "The current frame size is not supported");
+        static_assert(frame_length <= Serial::max_framebuffer_size, "The current buffer size is not supported");
+
+        // Qualify Worker Performance
+        //  Rows converted by core 0 between serial polls are not credited, this has not been measured. (See Matrix::Worker::assist)
+        static_assert(((2 * MULTIPLEX * COLUMNS * CHAINS * 3 * 2 * FPS * PWM_bits) / 1000000.0) <= 1.5, "CPU is only capable of so many operations per second.");
+    }
+}
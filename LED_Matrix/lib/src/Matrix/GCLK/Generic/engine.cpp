@@ -0,0 +1,15 @@
+/* 
+ * File:   engine.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+// Generic alone, its declarations take the names of BCM. (See algorithm.h)
+#include "Matrix/engine.h"
+#include "Matrix/GCLK/Generic/algorithm.h"
+
+namespace Matrix {
+    typedef Engine<BCM::Algorithm> engine;
+}
+
+#include "Matrix/engine_api.h"
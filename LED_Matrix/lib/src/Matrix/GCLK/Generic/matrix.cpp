@@ -0,0 +1,318 @@
+/* 
+ * File:   matrix.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+ 
+#include <stdint.h>
+#include <string.h>
+#include "pico/platform.h"
+#include "hardware/pio.h"
+#include "hardware/gpio.h"
+#include "hardware/dma.h"
+#include "hardware/timer.h"
+#include "hardware/structs/bus_ctrl.h"
+#include "Matrix/config.h"
+#include "Matrix/matrix.h"
+#include "Matrix/GCLK/Generic/memory_format.h"
+#include "Matrix/GCLK/Generic/algorithm.h"
+#include "Multiplex/Multiplex.h"
+#include "Serial/config.h"
+#include "Matrix/GCLK/hw_config.h"
+#include "Multiplex/HUB75/hw_config.h"
+
+// Names are the ones of BCM, Generic runs the BCM worker. (See algorithm.h)
+namespace Matrix::BCM {
+    static Buffer *buffer = nullptr;
+    static int dma_chan;
+    static uint8_t bank;
+    static bool pending = false;
+
+    // PIO Protocol
+    //  The drivers do the PWM, the bank is shifted once per frame instead of once per row. (See Buffer.cpp)
+    //      The stream is a list of blocks, the first word of every block is the program address of the block.
+    //          Command blocks hold LE low and LE high element counts followed by the elements. (VSYNC, PRE_ACTIVE, WRITE_CONFIG)
+    //          Data blocks hold the driver count followed by PWM_bits elements per driver. PIO shifts the zero padding.
+    //          The PIO logic is indexed from zero, and there is no way to command zero transfer length.
+    //      The stream is shifted while the drivers display the previous frame, VSYNC swaps the frames.
+    //          VSYNC is sent at the start of the next stream, at the end of the grayscale period. (See send_frame)
+    //  A second state machine drives GCLK, GCLK_PER_ROW pulses per row. (See hw_config.h)
+    //      Rows are switched by the CPU in between, the drivers scan every row sub_periods times per frame.
+
+    // PIO waits on this flag before the GCLKs of a row. (Row address has settled)
+    constexpr uint32_t gclk_irq = 4;
+
+    // Command blocks sent once at start, the elements are the configuration register of every driver. (MSB first)
+    static uint32_t pre_active[command_length(GCLK::GCLK_LE_PRE_ACTIVE) / 4];
+    static uint32_t write_config[(12 + (drivers * GCLK::GCLK_CHANNEL_BITS * sizeof(line_t))) / 4];
+
+    static void send_frame();
+    static void send_command(uint32_t *p, uint32_t len);
+
+    // Multiplex is started by the engine (See Matrix/engine.h)
+    void init() {
+        // Init Matrix hardware
+        // IO
+        for (int i = 0; i < Matrix::GCLK::GCLK_DATA_LEN; i++) {
+            gpio_init(i + Matrix::GCLK::GCLK_DATA_BASE);
+            gpio_set_dir(i + Matrix::GCLK::GCLK_DATA_BASE, GPIO_OUT);
+            gpio_set_function(i + Matrix::GCLK::GCLK_DATA_BASE, GPIO_FUNC_PIO0);
+        }
+        gpio_init(Matrix::GCLK::GCLK_GCLK);
+        gpio_set_dir(Matrix::GCLK::GCLK_GCLK, GPIO_OUT);
+        gpio_clr_mask((((1 << Matrix::GCLK::GCLK_DATA_LEN) - 1) << Matrix::GCLK::GCLK_DATA_BASE) | (1 << Matrix::GCLK::GCLK_GCLK));
+
+        // Promote the CPUs (Branches break sequential/stripping pattern)
+        //  CPUs now have 50 percent chance of winning.
+        //      They now have 1 turn loss max penalty.
+        //      Performance is 0.5 to 1
+        //  DMA now has 50 percent chance of losing.
+        //      They now have 3+ turn loss max penalty.
+        //      Performance is <0.25 to 1
+        bus_ctrl_hw->priority = (1 << 4) | (1 << 0);
+
+        // Drivers with built in PWM (GCLK), grayscale is shifted once per frame.
+        //  DCLK and LE are automated by DMA and PIO for the entire bank, GCLK is automated by a second state machine.
+        //      Serial clocks per frame are MULTIPLEX * 16 * COLUMNS, independent of the refresh.
+        //      Row switching is left to the CPU. (Multiplex Algorithm)
+        //
+        //  while (1) {                                     // State machine 0 (DCLK, LE and data)
+        //      pc = DATA;                                  // Start of block, DMA push into FIFO (data stream protocol)
+        //  }
+        //  Command:
+        //      counter = DATA; counter2 = DATA;            // LE low and LE high elements
+        //      do {
+        //          DAT = DATA; CLK = 0;
+        //          CLK = 1;
+        //      } while (counter-- > 0);
+        //      do {
+        //          DAT = DATA; LAT = 1; CLK = 0;
+        //          CLK = 1;                                // Driver counts the rising edges with LE high
+        //      } while (counter2-- > 0); LAT = 0;
+        //  Data:
+        //      counter = DATA;                             // Drivers
+        //      do {
+        //          counter2 = pad_bits - 1;
+        //          do {
+        //              DAT = 0; CLK = 0;                   // Zero padding
+        //              CLK = 1;
+        //          } while (counter2-- > 0);
+        //          counter2 = PWM_bits - 2;
+        //          do {
+        //              DAT = DATA; CLK = 0;                // Payload data, DMA push into FIFO (data stream protocol)
+        //              CLK = 1;
+        //          } while (counter2-- > 0);
+        //          DAT = DATA; CLK = 0; LAT = (counter == 0);  // Data latch on the last DCLK of the block
+        //          CLK = 1;
+        //      } while (counter-- > 0); LAT = 0;
+        //
+        //  gclk = GCLK_PER_ROW - 1;                        // State machine 1 (GCLK), manually push into FIFO once
+        //  while (1) {
+        //      wait(gclk_irq);                             // Row address has settled (See timer_isr)
+        //      counter = gclk;
+        //      do {
+        //          GCLK = 1;
+        //          GCLK = 0;
+        //      } while (counter-- > 0);
+        //      irq(1);                                     // End of row (See pio_isr)
+        //  }
+
+        // PIO
+        const uint16_t instructions[] = {
+            (uint16_t) (pio_encode_out(pio_pc, 32) | pio_encode_sideset(2, 0)),     // PIO SM (Block address)
+            (uint16_t) (pio_encode_out(pio_x, 32) | pio_encode_sideset(2, 0)),      // Command (command_pc)
+            (uint16_t) (pio_encode_out(pio_y, 32) | pio_encode_sideset(2, 0)),
+            (uint16_t) (pio_encode_out(pio_pins, 8 * sizeof(line_t)) | pio_encode_sideset(2, 0)),    // PMP Program (Only 6 pins per chain are mapped)
+            (uint16_t) (pio_encode_jmp_x_dec(3) | pio_encode_sideset(2, 1)),
+            (uint16_t) (pio_encode_out(pio_pins, 8 * sizeof(line_t)) | pio_encode_sideset(2, 2)),
+            (uint16_t) (pio_encode_jmp_y_dec(5) | pio_encode_sideset(2, 3)),
+            (uint16_t) (pio_encode_jmp(0) | pio_encode_sideset(2, 0)),
+            (uint16_t) (pio_encode_out(pio_x, 32) | pio_encode_sideset(2, 0)),      // Data (data_pc)
+            (uint16_t) (pio_encode_set(pio_y, pad_bits - 1) | pio_encode_sideset(2, 0)),
+            (uint16_t) (pio_encode_mov(pio_pins, pio_null) | pio_encode_sideset(2, 0)),
+            (uint16_t) (pio_encode_jmp_y_dec(10) | pio_encode_sideset(2, 1)),
+            (uint16_t) (pio_encode_set(pio_y, PWM_bits - 2) | pio_encode_sideset(2, 0)),
+            (uint16_t) (pio_encode_out(pio_pins, 8 * sizeof(line_t)) | pio_encode_sideset(2, 0)),    // PMP Program (Only 6 pins per chain are mapped)
+            (uint16_t) (pio_encode_jmp_y_dec(13) | pio_encode_sideset(2, 1)),
+            (uint16_t) (pio_encode_jmp_not_x(18) | pio_encode_sideset(2, 0)),
+            (uint16_t) (pio_encode_out(pio_pins, 8 * sizeof(line_t)) | pio_encode_sideset(2, 0)),
+            (uint16_t) (pio_encode_jmp_x_dec(9) | pio_encode_sideset(2, 1)),
+            (uint16_t) (pio_encode_out(pio_pins, 8 * sizeof(line_t)) | pio_encode_sideset(2, 2)),    // Data latch
+            (uint16_t) (pio_encode_jmp(0) | pio_encode_sideset(2, 3))
+        };
+        static const struct pio_program pio_programs = {
+            .instructions = instructions,
+            .length = count_of(instructions),
+            .origin = 0,
+        };
+        const uint16_t gclk_instructions[] = {
+            (uint16_t) (pio_encode_pull(false, true) | pio_encode_sideset(1, 0)),   // PIO SM
+            (uint16_t) (pio_encode_mov(::pio_isr, pio_osr) | pio_encode_sideset(1, 0)),
+            (uint16_t) (pio_encode_wait_irq(true, false, gclk_irq) | pio_encode_sideset(1, 0)),
+            (uint16_t) (pio_encode_mov(pio_x, ::pio_isr) | pio_encode_sideset(1, 0)),
+            (uint16_t) (pio_encode_nop() | pio_encode_sideset(1, 1)),               // GCLK Program
+            (uint16_t) (pio_encode_jmp_x_dec(4) | pio_encode_sideset(1, 0)),
+            (uint16_t) (pio_encode_irq_set(false, 1) | pio_encode_sideset(1, 0))    // End of row
+        };
+        static const struct pio_program gclk_programs = {
+            .instructions = gclk_instructions,
+            .length = count_of(gclk_instructions),
+            .origin = -1,
+        };
+        pio_add_program(pio0, &pio_programs);
+        const uint gclk_offset = pio_add_program(pio0, &gclk_programs);             // Jumps are relocated
+        pio_sm_set_consecutive_pindirs(pio0, 0, Matrix::GCLK::GCLK_DATA_BASE, Matrix::GCLK::GCLK_DATA_LEN, true);
+        pio_sm_set_consecutive_pindirs(pio0, 1, Matrix::GCLK::GCLK_GCLK, 1, true);
+
+        // Verify pins (Chains, DCLK and LE are consecutive)
+        static_assert((Matrix::GCLK::GCLK_DATA_BASE + Matrix::GCLK::GCLK_DATA_LEN) <= 30, "Not enough pins for the number of chains");
+        static_assert((Matrix::GCLK::GCLK_GCLK < Matrix::GCLK::GCLK_DATA_BASE) || (Matrix::GCLK::GCLK_GCLK >= (Matrix::GCLK::GCLK_DATA_BASE + Matrix::GCLK::GCLK_DATA_LEN)), "GCLK overlaps the data pins");
+        static_assert(((Matrix::GCLK::GCLK_DATA_BASE + Matrix::GCLK::GCLK_DATA_LEN) <= Multiplex::HUB75::HUB75_ADDR_BASE) || (Matrix::GCLK::GCLK_DATA_BASE >= (Multiplex::HUB75::HUB75_ADDR_BASE + Multiplex::HUB75::HUB75_ADDR_LEN)), "Data pins overlap the address pins, move GCLK_DATA_BASE or HUB75_ADDR_BASE");
+        static_assert((Matrix::GCLK::GCLK_GCLK < Multiplex::HUB75::HUB75_ADDR_BASE) || (Matrix::GCLK::GCLK_GCLK >= (Multiplex::HUB75::HUB75_ADDR_BASE + Multiplex::HUB75::HUB75_ADDR_LEN)), "GCLK overlaps the address pins");
+        static_assert((CHAINS >= 1) && (CHAINS <= 3), "Only 1 to 3 chains are supported");
+
+        // Verify Serial Clock and Grayscale Clock
+        constexpr float x = 125000000.0 / (SERIAL_CLOCK * 2.0);
+        constexpr float g = 125000000.0 / (GRAYSCALE_CLOCK * 2.0);
+        static_assert(x >= 1.0, "Unabled to configure PIO for SERIAL_CLOCK");
+        static_assert(g >= 1.0, "Unabled to configure PIO for GRAYSCALE_CLOCK");
+
+        Calculator::verify_configuration();
+
+        // PMP / SM
+        pio0->sm[0].clkdiv = ((uint32_t) floor(x) << PIO_SM0_CLKDIV_INT_LSB) | ((uint32_t) round((x - floor(x)) * 255.0) << PIO_SM0_CLKDIV_FRAC_LSB);
+        pio0->sm[0].pinctrl = (2 << PIO_SM0_PINCTRL_SIDESET_COUNT_LSB) | ((6 * CHAINS) << PIO_SM0_PINCTRL_OUT_COUNT_LSB) | (Matrix::GCLK::GCLK_DCLK << PIO_SM0_PINCTRL_SIDESET_BASE_LSB) | (Matrix::GCLK::GCLK_DATA_BASE << PIO_SM0_PINCTRL_OUT_BASE_LSB);
+        pio0->sm[0].shiftctrl = (1 << PIO_SM0_SHIFTCTRL_AUTOPULL_LSB) | (0 << PIO_SM0_SHIFTCTRL_PULL_THRESH_LSB) | (1 << PIO_SM0_SHIFTCTRL_OUT_SHIFTDIR_LSB);
+        pio0->sm[0].execctrl = (1 << PIO_SM1_EXECCTRL_OUT_STICKY_LSB) | ((count_of(instructions) - 1) << PIO_SM1_EXECCTRL_WRAP_TOP_LSB);
+        pio0->sm[0].instr = pio_encode_jmp(0);
+
+        // GCLK / SM (Own clock, two cycles per GCLK)
+        pio0->sm[1].clkdiv = ((uint32_t) floor(g) << PIO_SM0_CLKDIV_INT_LSB) | ((uint32_t) round((g - floor(g)) * 255.0) << PIO_SM0_CLKDIV_FRAC_LSB);
+        pio0->sm[1].pinctrl = (1 << PIO_SM0_PINCTRL_SIDESET_COUNT_LSB) | (Matrix::GCLK::GCLK_GCLK << PIO_SM0_PINCTRL_SIDESET_BASE_LSB);
+        pio0->sm[1].execctrl = ((gclk_offset + count_of(gclk_instructions) - 1) << PIO_SM1_EXECCTRL_WRAP_TOP_LSB) | ((gclk_offset + 2) << PIO_SM0_EXECCTRL_WRAP_BOTTOM_LSB);
+        pio0->sm[1].instr = pio_encode_jmp(gclk_offset);
+        pio_sm_put(pio0, 1, Matrix::GCLK::GCLK_PER_ROW - 1);
+        hw_set_bits(&pio0->ctrl, 3 << PIO_CTRL_SM_ENABLE_LSB);
+        pio_sm_claim(pio0, 0);
+        pio_sm_claim(pio0, 1);
+        gpio_set_function(Matrix::GCLK::GCLK_GCLK, GPIO_FUNC_PIO0);                 // GCLK state machine waits on the first row
+
+        pio0_hw->inte0 = PIO_IRQ0_INTE_SM1_BITS;                                    // End of row (See pio_isr)
+
+        if constexpr (Matrix::GCLK::GCLK_CONFIG != 0) {
+            constexpr uint32_t config_elements = drivers * Matrix::GCLK::GCLK_CHANNEL_BITS;
+            constexpr uint32_t mask = (1 << (6 * CHAINS)) - 1;                      // Every data pin of every chain
+            line_t *e = (line_t *) &write_config[3];
+
+            pre_active[0] = command_pc;
+            pre_active[1] = command_elements(Matrix::GCLK::GCLK_LE_PRE_ACTIVE) - Matrix::GCLK::GCLK_LE_PRE_ACTIVE - 1;
+            pre_active[2] = Matrix::GCLK::GCLK_LE_PRE_ACTIVE - 1;
+
+            write_config[0] = command_pc;
+            write_config[1] = config_elements - Matrix::GCLK::GCLK_LE_WRITE_CONFIG - 1;
+            write_config[2] = Matrix::GCLK::GCLK_LE_WRITE_CONFIG - 1;
+
+            for (uint32_t i = 0; i < config_elements; i++)
+                e[i] = ((Matrix::GCLK::GCLK_CONFIG >> (Matrix::GCLK::GCLK_CHANNEL_BITS - 1 - (i % Matrix::GCLK::GCLK_CHANNEL_BITS))) & 1) ? mask : 0;
+
+            send_command(pre_active, count_of(pre_active));
+            send_command(write_config, count_of(write_config));
+        }
+
+        // DMA
+        dma_chan = dma_claim_unused_channel(true);
+        dma_channel_config c = dma_channel_get_default_config(dma_chan);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_high_priority(&c, true);
+        channel_config_set_dreq(&c, DREQ_PIO0_TX0);
+        dma_channel_configure(dma_chan, &c, &pio0_hw->txf[0], NULL, 0, false);
+    }
+
+    // Row 0 is selected by Multiplex::init, the GCLK state machine waits on it.
+    void resume() {
+        // Display starts with a blank bank, waiting for a frame here would deadlock core 1. (Worker has not started yet)
+        send_frame();
+        pio0_hw->irq_force = 1 << gclk_irq;                                         // Row address is already set
+    }
+
+    // Command blocks are only sent at start, before the first stream. (Blocks until shifted)
+    static void send_command(uint32_t *p, uint32_t len) {
+        for (uint32_t i = 0; i < len; i++)
+            pio_sm_put_blocking(pio0, 0, p[i]);
+
+        while (!pio_sm_is_tx_fifo_empty(pio0, 0) || (pio0->sm[0].addr != 0)) {
+            // Wait for the command to be shifted
+        }
+    }
+
+    // Starts the stream of the front bank at the end of the grayscale period (See PIO Protocol)
+    //  The stream starts with VSYNC if the previous stream was not latched yet.
+    //  The previous stream must be shifted completely, otherwise the displayed frame is repeated.
+    static void __not_in_flash_func(send_frame)() {
+        if (dma_channel_is_busy(dma_chan) || !pio_sm_is_tx_fifo_empty(pio0, 0) || (pio0->sm[0].addr != 0))
+            return;
+
+        uint8_t temp;
+        Buffer *p = Worker::get_front_buffer(&temp);
+
+        if (p != nullptr || buffer == nullptr) {
+            buffer = &Worker::buf[temp];
+            bank = temp;
+
+            // Bank starts with VSYNC (See Buffer.cpp)
+            if (pending)
+                dma_channel_transfer_from_buffer_now(dma_chan, buffer->get_line(0, 0) - vsync_length, frame_length / 4);
+            else
+                dma_channel_transfer_from_buffer_now(dma_chan, buffer->get_line(0, 0), (frame_length - vsync_length) / 4);
+
+            pending = true;
+        }
+        else if (pending) {
+            dma_channel_transfer_from_buffer_now(dma_chan, buffer->get_line(0, 0) - vsync_length, vsync_length / 4);
+            pending = false;
+        }
+    }
+
+    void __not_in_flash_func(dma_isr)() {
+        // Do nothing
+    }
+
+    void __not_in_flash_func(pio_isr)() {
+        static uint32_t rows = 0;
+        static uint32_t scans = 0;
+
+        if (pio0_hw->ints0 & PIO_IRQ0_INTS_SM1_BITS) {                              // Verify who called this (GCLK is already stopped)
+            timer_hw->alarm[timer] = time_us_32() + BLANK_TIME + 1;                 // Load timer (We don't care if it rolls over!)
+            timer_hw->armed = 1 << timer;                                           // Kick off timer
+            pio0_hw->irq = 2;                                                       // Clear the interrupt
+
+            if (++rows >= MULTIPLEX) {                                              // Fire rate: REFRESH
+                rows = 0;
+
+                if (++scans >= sub_periods) {                                       // Fire rate: REFRESH / sub_periods (End of the grayscale period)
+                    scans = 0;
+                    send_frame();
+                }
+            }
+
+            Multiplex::SetRow(rows);
+        }
+    }
+
+    void __not_in_flash_func(timer_isr)() {
+        if (timer_hw->ints & (1 << timer)) {                                        // Verify who called this
+            pio0_hw->irq_force = 1 << gclk_irq;                                     // Start the GCLKs of the row
+            timer_hw->intr = 1 << timer;                                            // Clear the interrupt
+        }
+    }
+
+    // Only the configuration is supported. (Profile 0)
+    bool set_profile(uint8_t profile) {
+        return profile == 0;
+    }
+
+    uint8_t get_profiles() {
+        return 1;
+    }
+}
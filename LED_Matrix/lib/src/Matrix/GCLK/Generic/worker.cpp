@@ -0,0 +1,13 @@
+/* 
+ * File:   worker.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+// Generic uses the BCM worker, only the memory format differs. (See Matrix/HUB75/BCM/worker.h)
+//  Bitplane i of a column is written into the data block of its channel. (See Buffer.cpp)
+//  Memory formats share their include guard, the GCLK format is included first and takes the place of the BCM format.
+//      Declarations of the algorithm do the same with the BCM declarations. (See algorithm.h)
+#include "Matrix/GCLK/Generic/memory_format.h"
+#include "Matrix/GCLK/Generic/algorithm.h"
+#include "Matrix/HUB75/BCM/worker.h"
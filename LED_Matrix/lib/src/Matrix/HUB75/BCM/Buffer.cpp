@@ -6,33 +6,69 @@
 
 #include <string.h>
 #include "pico/multicore.h"
-#include "Matrix/Buffer.h"
+#include "Matrix/HUB75/BCM/algorithm.h"
 #include "Matrix/HUB75/BCM/memory_format.h"
 
-// Every line starts with a counter variable indexed from zero instead of one
+// Every line starts with a counter word indexed from zero instead of one
+//  Columns are padded at the start of the line to whole words. (Padding is shifted off the end of the panel)
+//  Every column is a line_t element holding all chains.
+
+namespace Matrix::BCM {
+    constexpr uint32_t column_offset = 4 + ((line_columns - COLUMNS) * sizeof(line_t));
 
-namespace Matrix {
     Buffer::Buffer() {
+        memset(buf, 0, sizeof(buf));
+
         // Fill in counter variable
-        memset(buf, COLUMNS - 1, sizeof(buf));
+        for (uint8_t y = 0; y < MULTIPLEX; y++)
+            for (uint16_t i = 0; i < PWM_bits; i++)
+                *((uint32_t *) get_line(y, i)) = line_columns - 1;
     }
 
-    void Buffer::set_value(uint8_t multiplex, uint16_t index, uint8_t column, uint8_t value) {
-        uint32_t i = multiplex * PWM_bits * (COLUMNS + 1);
-        i += index * (COLUMNS + 1);
-        i += column;
+    // Chains share an element, the other chains must be preserved.
+    static inline void set_element(line_t *element, uint8_t chain, uint8_t value) {
+        if constexpr (CHAINS == 1)
+            *element = value;
+        else
+            *element = (*element & ~(0x3F << (6 * chain))) | (value << (6 * chain));
+    }
 
-        buf[i] = value;
+    void Buffer::set_value(uint8_t multiplex, uint16_t index, uint16_t column, uint8_t chain, uint8_t value) {
+        uint32_t i = multiplex * row_length;
+        i += index * line_length;
+        i += column_offset + (column * sizeof(line_t));
+
+        set_element((line_t *) &buf[i], chain, value);
+    }
+
+    // Writes four columns, one per byte lane (LSB first)
+    //  Columns are only word aligned if there is no padding and a single chain, otherwise this is done per column.
+    void Buffer::set_word(uint8_t multiplex, uint16_t index, uint16_t column, uint8_t chain, uint32_t value) {
+        uint32_t i = multiplex * row_length;
+        i += index * line_length;
+        i += column_offset + (column * sizeof(line_t));
+
+        if constexpr ((CHAINS == 1) && ((column_offset % 4) == 0)) {
+            *((uint32_t *) &buf[i]) = value;
+        }
+        else {
+            for (uint32_t j = 0; j < 4; j++)
+                set_element(((line_t *) &buf[i]) + j, chain, (value >> (j * 8)) & 0xFF);
+        }
     }
 
     uint8_t *Buffer::get_line(uint8_t multiplex, uint16_t index) {
-        uint32_t i = multiplex * PWM_bits * (COLUMNS + 1);
-        i += index * (COLUMNS + 1);
+        uint32_t i = multiplex * row_length;
+        i += index * line_length;
 
         return &buf[i];
     }
 
-    uint8_t Buffer::get_line_length() {
-        return COLUMNS + 1;
+    uint16_t Buffer::get_line_length() {
+        return line_length;
+    }
+
+    uint8_t Buffer::get_column_offset() {
+        return column_offset;
     }
 }
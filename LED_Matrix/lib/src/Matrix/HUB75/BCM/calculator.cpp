@@ -10,7 +10,7 @@
 #include "Matrix/matrix.h"
 #include "Serial/config.h"
 
-namespace Matrix::Calculator {
+namespace Matrix::BCM::Calculator {
     // Panel constants
     constexpr double max_clk_mhz = 25.0;
     constexpr uint8_t columns_per_driver = 16;
@@ -24,32 +24,59 @@ namespace Matrix::Calculator {
     constexpr uint8_t max_led_cap_pf = 18;
     constexpr uint8_t min_led_harmonics = 5;
 
+    // Matrix ISRs (pio_isr and timer_isr per row, see matrix.cpp)
+    constexpr double max_isr_rate = 200000.0;
+
+    // Display is off for the blank time of every row. (See matrix.cpp)
+    //  The first line of the row is shifted during the blank time, the end of row is signaled by PIO.
+    //      Blank time is extended if the first line takes longer to shift.
     static constexpr double get_refresh_overhead() {
+        const double first_line_us = (line_cycles * 1000000.0) / (2.0 * SERIAL_CLOCK);
         double refresh_overhead = 1000000.0 / (MULTIPLEX * MIN_REFRESH);
-        refresh_overhead /= refresh_overhead - BLANK_TIME;
+        refresh_overhead /= refresh_overhead - std::max((double) BLANK_TIME, first_line_us);
         return refresh_overhead;
     }
 
+    // Highest refresh with the least significant bitplane on for one PIO cycle (See memory_format.h)
+    //  Limited by shifting the bitplanes, not by 2^PWM_bits shifts.
+    static constexpr double get_max_refresh() {
+        return (2.0 * SERIAL_CLOCK) / (MULTIPLEX * get_row_cycles(1));
+    }
+
     static constexpr void is_clk_valid() {
-        constexpr uint64_t temp = (COLUMNS / columns_per_driver) * (max_impedance * fanout_per_clk * min_harmonics * max_par_cap_pf);
+        // CLK is shared by every chain
+        constexpr uint64_t temp = CHAINS * (COLUMNS / columns_per_driver) * (max_impedance * fanout_per_clk * min_harmonics * max_par_cap_pf);
         constexpr double hz_limit = BYPASS_FANOUT ? max_clk_mhz * 1000000.0 : 
             std::min(max_clk_mhz, (double) (1000000.0 / (temp * 1.0))) * 1000000.0;
-        constexpr double clk_hz = hz_limit / (MIN_REFRESH * get_refresh_overhead() * COLUMNS * MULTIPLEX * ((1 << PWM_bits) + 1));
+        constexpr double clk_hz = hz_limit / (MIN_REFRESH * get_refresh_overhead() * line_columns * MULTIPLEX * PWM_bits);     // Every bitplane is shifted once
 
         static_assert(SERIAL_CLOCK <= hz_limit, "Serial clock is too high");
         static_assert(clk_hz >= 1.0, "Configuration is not possible");
+        static_assert(MIN_REFRESH <= get_max_refresh(), "Refresh is too high to shift the bitplanes");
     }
 
     static constexpr void is_brightness_valid() {
         constexpr double led_rise_us = (max_led_impedance * min_led_harmonics * max_led_cap_pf * MULTIPLEX) / 1000000.0;
         constexpr double period_us = 1000000.0 / (MIN_REFRESH * MULTIPLEX);
-        constexpr double brightness = ((period_us / get_refresh_overhead()) - (led_rise_us * PWM_bits / 2.0)) / period_us;
-        constexpr double accuracy = ((period_us / get_refresh_overhead()) - (led_rise_us * PWM_bits / 2.0)) / (period_us / get_refresh_overhead());
+        constexpr double on_us = (lsb_cycles * ((1 << PWM_bits) - 1) * 1000000.0) / (2.0 * SERIAL_CLOCK);  // OE is off between bitplanes and during the blank time
+        constexpr double brightness = (on_us - (led_rise_us * PWM_bits / 2.0)) / period_us;
+        constexpr double accuracy = (on_us - (led_rise_us * PWM_bits / 2.0)) / on_us;
 
         static_assert(brightness > 0.75, "Brightness less than 75 percent is not recommended");
         static_assert(accuracy > 0.95, "Accuracy less than 95 percent is not recommended");
     }
 
+    // Profile 0 is the configuration, the last profile has the shortest rows. (See memory_format.h)
+    //  Rows are sequenced by interrupts, or by DMA with one interrupt per refresh.
+    static constexpr void is_profiles_valid() {
+        constexpr double max_refresh = get_profile_refresh(PROFILES - 1);
+        constexpr double row_rate = DMA_SCAN ? max_refresh : (MULTIPLEX * max_refresh);
+
+        static_assert((PROFILES >= 1) && (PROFILES < PWM_bits), "Every profile must keep at least two bitplanes");
+        static_assert(get_row_cycles(lsb_cycles, get_profile_planes(PROFILES - 1)) <= period_cycles, "Profile does not fit in the row period");
+        static_assert(row_rate <= max_isr_rate, "Profile refresh is too high for the Matrix ISRs");
+    }
+
     static constexpr void is_blank_time_valid() {
         constexpr double led_fall_us_high = (10000 * COLUMNS * max_led_cap_pf) / 1000000.0;
 
@@ -70,16 +97,18 @@ namespace Matrix::Calculator {
         is_brightness_valid();
         is_clk_valid();
         is_blank_time_valid();
+        is_profiles_valid();
         
         static_assert(COLUMNS >= columns_per_driver, "COLUMNS less than 8 is not recommended");
-        static_assert(COLUMNS <= 255, "COLUMNS more than 1024 is not recommended, but we only support up to 255");
-        static_assert((2 * MULTIPLEX * COLUMNS) <= 8192, "More than 8192 pixels is not recommended");
-        static_assert((2 * MULTIPLEX * COLUMNS * sizeof(Serial::DEFINE_SERIAL_RGB_TYPE)) <= Serial::payload_size, "The current frame size is not supported");
-        static_assert((MULTIPLEX * COLUMNS * (PWM_bits)) <= Serial::max_framebuffer_size, "The current buffer size is not supported");
+        static_assert(COLUMNS <= 1024, "COLUMNS more than 1024 is not recommended");
+        static_assert((2 * MULTIPLEX * COLUMNS * CHAINS) <= 8192, "More than 8192 pixels is not recommended");
+        static_assert((2 * MULTIPLEX * COLUMNS * CHAINS * sizeof(Serial::DEFINE_SERIAL_RGB_TYPE)) <= Serial::payload_size, "The current frame size is not supported");
+        static_assert((MULTIPLEX * row_length) <= Serial::max_framebuffer_size, "The current buffer size is not supported");
         static_assert((MULTIPLEX * (1 << PWM_bits)) <= (4 * 1024), "The current LED grayscale is not supported");
         static_assert(MIN_REFRESH > 2 * FPS, "Refresh rate must be higher than twice the number of frames per second");
 
         // Qualify Worker Performance
-        static_assert(((2 * MULTIPLEX * COLUMNS * 3 * 2 * FPS * PWM_bits) / 1000000.0) <= 1.5, "CPU is only capable of so many operations per second.");
+        //  Rows converted by core 0 between serial polls are not credited, this has not been measured. (See Matrix::Worker::assist)
+        static_assert(((2 * MULTIPLEX * COLUMNS * CHAINS * 3 * 2 * FPS * PWM_bits) / 1000000.0) <= 1.5, "CPU is only capable of so many operations per second.");
     }
 }
\ No newline at end of file
@@ -0,0 +1,15 @@
+/* 
+ * File:   engine.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+// BCM alone
+#include "Matrix/engine.h"
+#include "Matrix/HUB75/BCM/algorithm.h"
+
+namespace Matrix {
+    typedef Engine<BCM::Algorithm> engine;
+}
+
+#include "Matrix/engine_api.h"
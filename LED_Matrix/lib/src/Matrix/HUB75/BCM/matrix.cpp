@@ -12,49 +12,78 @@
 #include "hardware/dma.h"
 #include "hardware/timer.h"
 #include "hardware/structs/bus_ctrl.h"
+#include "hardware/structs/iobank0.h"
 #include "Matrix/config.h"
 #include "Matrix/matrix.h"
+#include "Matrix/engine.h"
 #include "Matrix/HUB75/BCM/memory_format.h"
+#include "Matrix/HUB75/BCM/algorithm.h"
 #include "Multiplex/Multiplex.h"
 #include "Serial/config.h"
 #include "Matrix/HUB75/hw_config.h"
+#include "Multiplex/HUB75/hw_config.h"
 
-namespace Matrix::Worker {
-    extern Matrix::Buffer *get_front_buffer();
-};
-
-namespace Matrix::Calculator {
-    extern void verify_configuration();
-};
-
-namespace Matrix::Worker {
-    extern Matrix::Buffer buf[Serial::num_framebuffers];
-
-    extern Matrix::Buffer *get_front_buffer(uint8_t *id);
-};
-
-namespace Matrix {
+namespace Matrix::BCM {
     static Buffer *buffer = nullptr;
     static volatile uint8_t state = 0;
     static int dma_chan[2];
-    volatile int timer;
     static uint8_t bank;
+    static uint32_t rows = 0;
+    static uint oe_offset;
+    static pio_program program;
+    static pio_program oe_program;
+
+    // Depth profile (See memory_format.h)
+    //  Requested by core 0, armed while the OE state machine is inside the last row and taken with the next refresh.
+    //      OE state machine loads its bitplane count at the start of every row, the instruction is only replaced while it is not there.
+    static volatile uint8_t profile_next = 0;
+    static uint8_t profile_armed = 0;
+    static uint8_t profile = 0;
 
     // PIO Protocol
-    //  There are 2^PWM_bits shifts per period.
+    //  Every bitplane is shifted once per row, the row is a single DMA transfer. (See Buffer.cpp)
     //      The serial protocol used by PIO is column length decremented by one followed by column values.
     //          The PIO logic is indexed from zero, and there is no way to command zero transfer length.
-    //      The serial protocol has a header which indicates the number of transfers to expect
-    //          This is loaded by the CPU manually before starting DMA (excludes null termination transfer)
-    //  There are 2^PWM_bits plus two transfers.
-    //      The second to last transfer turns the columns off before multiplexing. (Standard shift)
-    //      The last transfer stops the DMA and fires an interrupt.
-    static volatile struct {volatile uint32_t len; volatile uint8_t *data;} address_table[Serial::num_framebuffers][MULTIPLEX * ((1 << PWM_bits) + 2)];
-    static volatile uint8_t null_table[COLUMNS + 1];
+    //          Every transfer is a word, column length is a whole word and there are four columns per word. (See Buffer.cpp)
+    //      The serial protocol has a header which indicates the number of bitplanes to expect
+    //          This is loaded by the CPU manually before starting DMA
+    //  A second state machine drives OE, bitplane i is on for lsb_cycles * 2^i. (See memory_format.h)
+    //      The next bitplane is shifted while the current one is on, it is latched once OE is off again.
+    //      OE is off after the last bitplane, there is no blank line before multiplexing.
+
+    // PIO waits on this flag before latching the first line of a row. (Row address has settled)
+    constexpr uint32_t latch_irq = 4;
+
+    // Handoff between the state machines, bitplane latched and OE off again
+    constexpr uint32_t pulse_irq = 5;
+    constexpr uint32_t pulse_done_irq = 6;
+
+    // DMA Scan Protocol (DMA_SCAN)
+    //  DMA channel 0 runs control blocks loaded by DMA channel 1, seven per row:
+    //      Wait for PIO to finish the previous row. (PIO pushes a word into the RX FIFO after the last bitplane is off)
+    //      Row address
+    //      Header and first line into the PIO TX FIFO, PIO shifts it and waits on latch_irq.
+    //      Rest of the blank time (DMA timer at 1MHz) and latch_irq
+    //      Rest of the row into the PIO TX FIFO
+    //  The address pins are driven by the GPIO output override. (DMA can not reach SIO)
+    //      Shifted rows are one word into the shifter FIFO instead. (See Multiplex::GetRowWord)
+    //  Only the last row raises an interrupt, the CPU swaps banks and restarts the list once per refresh.
+    struct scan_block {const volatile void *read; volatile void *write; uint32_t len; uint32_t ctrl;};
+    constexpr uint32_t scan_row_blocks = 7;
+    static scan_block scan_table[DMA_SCAN ? (MULTIPLEX * scan_row_blocks) : 1];
+    static uint32_t scan_address[DMA_SCAN ? MULTIPLEX : 1][2 * Multiplex::HUB75::HUB75_ADDR_LEN];
+    static uint32_t scan_header;
+    static uint32_t scan_latch;
+    static uint32_t scan_dummy;
+    static bool scan = false;
 
     static void send_line(uint32_t row);
+    static void scan_init();
+    static void scan_load();
+    static void arm_profile();
 
-    void start() {
+    // Multiplex is started by the engine (See Matrix/engine.h)
+    void init() {
         // Init Matrix hardware
         // IO
         for (int i = 0; i < Matrix::HUB75::HUB75_DATA_LEN; i++) {
@@ -64,9 +93,14 @@ namespace Matrix {
         }
         gpio_init(Matrix::HUB75::HUB75_OE);
         gpio_set_dir(Matrix::HUB75::HUB75_OE, GPIO_OUT);
-        gpio_clr_mask(0x40FF00);
+        gpio_clr_mask(((1 << Matrix::HUB75::HUB75_DATA_LEN) - 1) << Matrix::HUB75::HUB75_DATA_BASE);
+        gpio_set_mask(1 << Matrix::HUB75::HUB75_OE);                                // Panel is off until the OE state machine starts
 
-        Multiplex::init(MULTIPLEX);
+        if constexpr (DMA_SCAN) {
+            uint32_t pins;
+            volatile uint32_t *fifo;
+            scan = Multiplex::GetRowPins(0, &pins) || Multiplex::GetRowWord(0, &pins, &fifo);  // Rows must be static pin levels or one word into a shifter
+        }
 
         // Promote the CPUs (Branches break sequential/stripping pattern)
         //  CPUs now have 50 percent chance of winning.
@@ -76,175 +110,335 @@ namespace Matrix {
         //      They now have 3+ turn loss max penalty. 
         //      Performance is <0.25 to 1
         bus_ctrl_hw->priority = (1 << 4) | (1 << 0);
-       
-        // Do not connect the dots (LEDs), charge the low side before scanning (This will turn the LEDs off)
-        //  Do use Dot correction though, which is above this implementation layer
-        memset((void *) null_table, 0, COLUMNS + 1);
-        null_table[0] = COLUMNS - 1;
-
-
-        { // Keep stack and variable scope clean
-            uint32_t y;
-
-            for (uint8_t b = 0; b < Serial::num_framebuffers; b++) {
-                for (uint32_t x = 0; x < MULTIPLEX; x++) {
-                    y = x * ((1 << PWM_bits) + 2);
-
-                    for (uint32_t i = 0; i < PWM_bits; i++) {
-                        for (uint32_t k = 0; k < (uint32_t) (1 << i); k++) {
-                            address_table[b][y + (1 << i) + k - 1].data = buffer->get_line(x, k);
-                        }
-
-                        address_table[b][y + i].len = Buffer::get_line_length();
-                    }
-                    
-                    y += 1 << PWM_bits;
-                    address_table[b][y].data = null_table;
-                    address_table[b][y].len = COLUMNS + 1;
-                    address_table[b][y + 1].data = NULL;
-                    address_table[b][y + 1].len = 0;
-                }
-            }
-        }
         
         // Hack to lower the ISR tick rate, accelerates by 2^PWM_bits (Improves refresh performance)
-        //  Automates CLK and LAT signals with DMA and PIO to handle Software PWM of entire row
-        //      Works like Hardware PWM without the high refresh
+        //  Automates CLK and LAT signals with DMA and PIO to handle BCM of entire row
+        //      Every bitplane is shifted once, OE is pulsed for its weight by a second state machine.
+        //          Serial clocks per row are PWM_bits * line_columns instead of 2^PWM_bits * line_columns.
         //      This is more or less how it would work with MACHXO2 FPGA and PIC32MX using PMP.
         //          Bus performance is better with RP2040. (Lower cost due to memory, CPU, hardware integration.)
-        //  OE is not used in this implementation and held to low to enable the display
-        //      Last shift will disable display.
         //
-        //  while (1) {
-        //      counter2 = (1 << PWM_bits) - 1; LAT = 0;    // Start of frame, manually push into FIFO (data stream protocol)
+        //  while (1) {                                     // State machine 0 (Data)
+        //      counter2 = PWM_bits - 1; LAT = 0;           // Start of frame, manually push into FIFO (data stream protocol)
         //      do {
-        //          counter = COLUMNS - 1;                  // Start of payload, DMA push into FIFO (data stream protocol)
+        //          counter = line_columns - 1;             // Start of payload, DMA push into FIFO (data stream protocol)
         //          do {
         //              DAT = DATA; CLK = 0;                // Payload data, DMA push into FIFO (data stream protocol)
         //              CLK = 1;                            // Automate CLK pulse
         //          } while (counter-- > 0); CLK = 0;
+        //          wait(first ? latch_irq : pulse_done_irq);   // First line is shifted during the blank time (See timer_isr)
         //          LAT = 1;                                // Automate LAT pulse at end of payload (bitplane shift)
-        //          LAT = 0;
+        //          irq(pulse_irq); LAT = 0;                // Start the OE pulse, the next bitplane is shifted meanwhile
+        //      } while (counter2-- > 0);
+        //      wait(pulse_done_irq);                       // Last bitplane is off
+        //      irq(0);                                     // End of row (See pio_isr)
+        //  }
+        //  DMA_SCAN: End of row pushes a word into the RX FIFO instead. (See DMA Scan Protocol)
+        //
+        //  weight = lsb_cycles - 1;                        // State machine 1 (OE), manually push into FIFO once
+        //  while (1) {
+        //      counter2 = PWM_bits - 1; counter = weight;
+        //      do {
+        //          wait(pulse_irq);
+        //          OE = 0; while (counter-- > 0); OE = 1;  // On for counter + 1 cycles
+        //          counter = (counter << 1) | 1;           // Next weight, (w + 1) * 2 - 1
+        //          irq(pulse_done_irq);
         //      } while (counter2-- > 0);
         //  }
         
-        // PIO
-        const uint16_t instructions[] = {
+        // PIO (Loaded by resume)
+        static const uint16_t instructions[] = {
             (uint16_t) (pio_encode_pull(false, true) | pio_encode_sideset(2, 0)),   // PIO SM
-            (uint16_t) (pio_encode_out(pio_x, 8) | pio_encode_sideset(2, 0)),
-            (uint16_t) (pio_encode_out(pio_y, 8) | pio_encode_sideset(2, 0)),
-            (uint16_t) (pio_encode_out(pio_pins, 6) | pio_encode_sideset(2, 0)),    // PMP Program
+            (uint16_t) (pio_encode_out(pio_x, 32) | pio_encode_sideset(2, 0)),
+            (uint16_t) (pio_encode_out(pio_y, 32) | pio_encode_sideset(2, 0)),      // First line
+            (uint16_t) (pio_encode_out(pio_pins, 8 * sizeof(line_t)) | pio_encode_sideset(2, 0)),    // PMP Program (Only 6 pins per chain are mapped)
             (uint16_t) (pio_encode_jmp_y_dec(3) | pio_encode_sideset(2, 1)),
+            (uint16_t) (pio_encode_wait_irq(true, false, latch_irq) | pio_encode_sideset(2, 0)),
+            (uint16_t) (pio_encode_jmp(11) | pio_encode_sideset(2, 0)),
+            (uint16_t) (pio_encode_out(pio_y, 32) | pio_encode_sideset(2, 0)),      // Other lines
+            (uint16_t) (pio_encode_out(pio_pins, 8 * sizeof(line_t)) | pio_encode_sideset(2, 0)),    // PMP Program (Only 6 pins per chain are mapped)
+            (uint16_t) (pio_encode_jmp_y_dec(8) | pio_encode_sideset(2, 1)),
+            (uint16_t) (pio_encode_wait_irq(true, false, pulse_done_irq) | pio_encode_sideset(2, 0)),
             (uint16_t) (pio_encode_nop() | pio_encode_sideset(2, 2)),
-            (uint16_t) (pio_encode_nop() | pio_encode_sideset(2, 2)),
-            (uint16_t) (pio_encode_nop() | pio_encode_sideset(2, 0)),
-            (uint16_t) (pio_encode_jmp_x_dec(2) | pio_encode_sideset(2, 0)),
+            (uint16_t) (pio_encode_irq_set(false, pulse_irq) | pio_encode_sideset(2, 2)),
+            (uint16_t) (pio_encode_jmp_x_dec(7) | pio_encode_sideset(2, 0)),
+            (uint16_t) (pio_encode_wait_irq(true, false, pulse_done_irq) | pio_encode_sideset(2, 0)),
+            (uint16_t) (((DMA_SCAN && scan) ? pio_encode_push(false, false) : pio_encode_irq_set(false, 0)) | pio_encode_sideset(2, 0)),    // End of row
             (uint16_t) (pio_encode_jmp(0) | pio_encode_sideset(2, 0))
         };
-        static const struct pio_program pio_programs = {
+        program = {
             .instructions = instructions,
             .length = count_of(instructions),
             .origin = 0,
         };
-        pio_add_program(pio0, &pio_programs);
-        pio_sm_set_consecutive_pindirs(pio0, 0, Matrix::HUB75::HUB75_DATA_BASE, Matrix::HUB75::HUB75_DATA_LEN, true);
+        static const uint16_t oe_instructions[] = {
+            (uint16_t) (pio_encode_pull(false, true) | pio_encode_sideset(1, 1)),   // PIO SM
+            (uint16_t) (pio_encode_set(pio_x, PWM_bits - 1) | pio_encode_sideset(1, 1)),
+            (uint16_t) (pio_encode_mov(::pio_isr, pio_osr) | pio_encode_sideset(1, 1)),
+            (uint16_t) (pio_encode_wait_irq(true, false, pulse_irq) | pio_encode_sideset(1, 1)),
+            (uint16_t) (pio_encode_mov(pio_y, ::pio_isr) | pio_encode_sideset(1, 1)),
+            (uint16_t) (pio_encode_jmp_y_dec(5) | pio_encode_sideset(1, 0)),        // OE Program (On time)
+            (uint16_t) (pio_encode_in(pio_y, 1) | pio_encode_sideset(1, 1)),        // Y is all ones after the loop
+            (uint16_t) (pio_encode_irq_set(false, pulse_done_irq) | pio_encode_sideset(1, 1)),
+            (uint16_t) (pio_encode_jmp_x_dec(3) | pio_encode_sideset(1, 1)),
+            (uint16_t) (pio_encode_jmp(1) | pio_encode_sideset(1, 1))
+        };
+        oe_program = {
+            .instructions = oe_instructions,
+            .length = count_of(oe_instructions),
+            .origin = -1,
+        };
         
+        // Verify pins (Chains, CLK and LAT are consecutive)
+        static_assert((Matrix::HUB75::HUB75_DATA_BASE + Matrix::HUB75::HUB75_DATA_LEN) <= 30, "Not enough pins for the number of chains");
+        static_assert((Matrix::HUB75::HUB75_OE < Matrix::HUB75::HUB75_DATA_BASE) || (Matrix::HUB75::HUB75_OE >= (Matrix::HUB75::HUB75_DATA_BASE + Matrix::HUB75::HUB75_DATA_LEN)), "OE overlaps the data pins");
+        static_assert(((Matrix::HUB75::HUB75_DATA_BASE + Matrix::HUB75::HUB75_DATA_LEN) <= Multiplex::HUB75::HUB75_ADDR_BASE) || (Matrix::HUB75::HUB75_DATA_BASE >= (Multiplex::HUB75::HUB75_ADDR_BASE + Multiplex::HUB75::HUB75_ADDR_LEN)), "Data pins overlap the address pins, move HUB75_DATA_BASE or HUB75_ADDR_BASE");
+        static_assert((Matrix::HUB75::HUB75_OE < Multiplex::HUB75::HUB75_ADDR_BASE) || (Matrix::HUB75::HUB75_OE >= (Multiplex::HUB75::HUB75_ADDR_BASE + Multiplex::HUB75::HUB75_ADDR_LEN)), "OE overlaps the address pins");
+        static_assert((CHAINS >= 1) && (CHAINS <= 3), "Only 1 to 3 chains are supported");
+        static_assert(PWM_bits <= 32, "Unable to count bitplanes in PIO");
+
+        Calculator::verify_configuration();
+    }
+
+    // Row 0 is selected and the panel is off, by Multiplex::init or by the frame boundary of the algorithm before.
+    //  Row 0 of the front bank is shifted during its blank time, the timer latches it. (See timer_isr)
+    void resume() {
+        pio_add_program(pio0, &program);
+        oe_offset = pio_add_program(pio0, &oe_program);                             // Jumps are relocated
+        pio_sm_set_consecutive_pindirs(pio0, 0, Matrix::HUB75::HUB75_DATA_BASE, Matrix::HUB75::HUB75_DATA_LEN, true);
+        pio_sm_set_consecutive_pindirs(pio0, 1, Matrix::HUB75::HUB75_OE, 1, true);
+
         // Verify Serial Clock
         constexpr float x = 125000000.0 / (SERIAL_CLOCK * 2.0);     // Someday this two will be a four.
         static_assert(x >= 1.0, "Unabled to configure PIO for SERIAL_CLOCK");
 
-        Calculator::verify_configuration();
-
         // PMP / SM
         pio0->sm[0].clkdiv = ((uint32_t) floor(x) << PIO_SM0_CLKDIV_INT_LSB) | ((uint32_t) round((x - floor(x)) * 255.0) << PIO_SM0_CLKDIV_FRAC_LSB);
-        pio0->sm[0].pinctrl = (2 << PIO_SM0_PINCTRL_SIDESET_COUNT_LSB) | (6 << PIO_SM0_PINCTRL_OUT_COUNT_LSB) | (14 << PIO_SM0_PINCTRL_SIDESET_BASE_LSB) | (Matrix::HUB75::HUB75_DATA_BASE << PIO_SM0_PINCTRL_OUT_BASE_LSB);
-        pio0->sm[0].shiftctrl = (1 << PIO_SM0_SHIFTCTRL_AUTOPULL_LSB) | (6 << PIO_SM0_SHIFTCTRL_PULL_THRESH_LSB) | (1 << PIO_SM0_SHIFTCTRL_OUT_SHIFTDIR_LSB);
-        pio0->sm[0].execctrl = (1 << PIO_SM1_EXECCTRL_OUT_STICKY_LSB) | (12 << PIO_SM1_EXECCTRL_WRAP_TOP_LSB);
+        pio0->sm[0].pinctrl = (2 << PIO_SM0_PINCTRL_SIDESET_COUNT_LSB) | ((6 * CHAINS) << PIO_SM0_PINCTRL_OUT_COUNT_LSB) | (Matrix::HUB75::HUB75_CLK << PIO_SM0_PINCTRL_SIDESET_BASE_LSB) | (Matrix::HUB75::HUB75_DATA_BASE << PIO_SM0_PINCTRL_OUT_BASE_LSB);
+        pio0->sm[0].shiftctrl = (1 << PIO_SM0_SHIFTCTRL_AUTOPULL_LSB) | (0 << PIO_SM0_SHIFTCTRL_PULL_THRESH_LSB) | (1 << PIO_SM0_SHIFTCTRL_OUT_SHIFTDIR_LSB);
+        pio0->sm[0].execctrl = (1 << PIO_SM1_EXECCTRL_OUT_STICKY_LSB) | ((program.length - 1) << PIO_SM1_EXECCTRL_WRAP_TOP_LSB);
         pio0->sm[0].instr = pio_encode_jmp(0);
-        hw_set_bits(&pio0->ctrl, 1 << PIO_CTRL_SM_ENABLE_LSB);
+
+        // OE / SM (Same clock, shifts left to double the weight)
+        pio0->sm[1].clkdiv = pio0->sm[0].clkdiv;
+        pio0->sm[1].pinctrl = (1 << PIO_SM0_PINCTRL_SIDESET_COUNT_LSB) | (Matrix::HUB75::HUB75_OE << PIO_SM0_PINCTRL_SIDESET_BASE_LSB);
+        pio0->sm[1].shiftctrl = (0 << PIO_SM0_SHIFTCTRL_IN_SHIFTDIR_LSB);
+        pio0->sm[1].execctrl = ((oe_offset + oe_program.length - 1) << PIO_SM1_EXECCTRL_WRAP_TOP_LSB) | (oe_offset << PIO_SM0_EXECCTRL_WRAP_BOTTOM_LSB);
+        pio0->sm[1].instr = pio_encode_jmp(oe_offset);
+        pio_sm_put(pio0, 1, lsb_cycles - 1);
+        arm_profile();                                                              // Program was loaded with the count of the configuration
+        profile = profile_armed;
+        hw_set_bits(&pio0->ctrl, 3 << PIO_CTRL_SM_ENABLE_LSB);
         pio_sm_claim(pio0, 0);
+        pio_sm_claim(pio0, 1);
+        pio_sm_set_pins_with_mask(pio0, 1, 1 << Matrix::HUB75::HUB75_OE, 1 << Matrix::HUB75::HUB75_OE);    // Held off until the first side set (Rows of another algorithm may be lit)
+        gpio_set_function(Matrix::HUB75::HUB75_OE, GPIO_FUNC_PIO0);                 // OE state machine drives it high now
+
+        if (!(DMA_SCAN && scan))
+            pio0_hw->inte0 = PIO_IRQ0_INTE_SM0_BITS;                                // End of row (See pio_isr)
         
         // DMA
         dma_chan[0] = dma_claim_unused_channel(true);
-        dma_chan[1] = dma_claim_unused_channel(true);
         dma_channel_config c = dma_channel_get_default_config(dma_chan[0]);
-        channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
         channel_config_set_read_increment(&c, true);
         channel_config_set_high_priority(&c, true);
         channel_config_set_dreq(&c, DREQ_PIO0_TX0);
-        channel_config_set_chain_to(&c, dma_chan[1]);
-        channel_config_set_irq_quiet(&c, true);
         dma_channel_configure(dma_chan[0], &c, &pio0_hw->txf[0], NULL, 0, false);
-        dma_channel_set_irq0_enabled(dma_chan[0], true); 
+
+        if (DMA_SCAN && scan) {
+            dma_chan[1] = dma_claim_unused_channel(true);
+            dma_channel_set_irq0_enabled(dma_chan[0], true);
+
+            c = dma_channel_get_default_config(dma_chan[1]);
+            channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+            channel_config_set_read_increment(&c, true);
+            channel_config_set_write_increment(&c, true);
+            channel_config_set_high_priority(&c, true);
+            channel_config_set_ring(&c, true, 4);                                       // 1 << 4 byte boundary on write ptr
+            dma_channel_configure(dma_chan[1], &c, &dma_hw->ch[dma_chan[0]].read_addr, &scan_table[0], 4, false);
+
+            scan_init();
+        }
+
+        // Display starts with the newest bank, waiting for a frame here would deadlock core 1. (Worker is not running or is switching)
+        Worker::get_front_buffer(&bank);
+        buffer = &Worker::buf[bank];
         
-        c = dma_channel_get_default_config(dma_chan[1]);
+        if (DMA_SCAN && scan) {
+            scan_load();
+            dma_channel_set_read_addr(dma_chan[1], &scan_table[1], true);           // Nothing to wait for before the first row
+        }
+        else {
+            send_line(0);
+            timer_hw->alarm[timer] = time_us_32() + BLANK_TIME + 1;                 // Load timer (We don't care if it rolls over!)
+            timer_hw->armed = 1 << timer;                                           // Kick off timer
+            state = 1;
+        }
+    }
+
+    // Called after the end of row interrupt of the last row, the last bitplane is off and row 0 is selected. (See Matrix/engine.h)
+    //  Row 0 may be in flight, DMA and the state machines are stopped where they are. SIO holds OE off again.
+    //  DMA_SCAN is never suspended, an engine does not build it. (See HUB75/ENGINE/CMakeLists.txt)
+    void suspend() {
+        hw_clear_bits(&pio0->ctrl, 3 << PIO_CTRL_SM_ENABLE_LSB);
+        pio0_hw->inte0 = 0;
+        gpio_set_mask(1 << Matrix::HUB75::HUB75_OE);
+        gpio_set_function(Matrix::HUB75::HUB75_OE, GPIO_FUNC_SIO);
+
+        dma_channel_abort(dma_chan[0]);
+
+        for (uint32_t sm = 0; sm < 2; sm++) {
+            pio_sm_clear_fifos(pio0, sm);
+            pio_sm_restart(pio0, sm);
+        }
+
+        pio0_hw->irq = 0xFF;                                                        // Next program starts without flags
+        pio_remove_program(pio0, &oe_program, oe_offset);
+        pio_remove_program(pio0, &program, 0);
+        pio_sm_unclaim(pio0, 0);
+        pio_sm_unclaim(pio0, 1);
+        dma_channel_unclaim(dma_chan[0]);
+        state = 0;
+    }
+
+    static uint32_t scan_ctrl(uint dreq, bool read_increment, bool write_increment, bool last) {
+        dma_channel_config c = dma_channel_get_default_config(dma_chan[0]);
         channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
-        channel_config_set_read_increment(&c, true);
-        channel_config_set_write_increment(&c, true);
+        channel_config_set_read_increment(&c, read_increment);
+        channel_config_set_write_increment(&c, write_increment);
         channel_config_set_high_priority(&c, true);
-        channel_config_set_ring(&c, true, 3);                                       // 1 << 3 byte boundary on write ptr
-        dma_channel_configure(dma_chan[1], &c, &dma_hw->ch[dma_chan[0]].al3_transfer_count, &address_table[bank][0], 2, false);
+        channel_config_set_dreq(&c, dreq);
+        channel_config_set_chain_to(&c, last ? dma_chan[0] : dma_chan[1]);         // Chain to self stops the list
+        channel_config_set_irq_quiet(&c, !last);
+        return channel_config_get_ctrl_value(&c);
+    }
 
-        timer = hardware_alarm_claim_unused(true);
-        timer_hw->inte |= 1 << timer;
+    // Builds the control blocks (See DMA Scan Protocol)
+    //  DMA finishes the first line block after PIO has shifted it, that time counts towards the blank time.
+    static void scan_init() {
+        constexpr uint32_t first_line_us = (uint32_t) ((line_cycles * 1000000.0) / (2.0 * SERIAL_CLOCK));
+        constexpr uint32_t scan_blank = ((BLANK_TIME + 1) > first_line_us) ? ((BLANK_TIME + 1) - first_line_us) : 1;
+        const uint dma_timer = dma_claim_unused_timer(true);
+        const uint32_t sio = GPIO_FUNC_SIO << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB;
+        dma_timer_set_fraction(dma_timer, 1, 125);                                  // 1MHz from 125MHz
 
-        do {
-            buffer = Worker::get_front_buffer(&bank);
-        } while (buffer == nullptr);
-        
-        send_line(0);
+        scan_header = PWM_bits - 1;                                                 // Bitplanes
+        scan_latch = 1 << latch_irq;
+
+        for (uint32_t y = 0; y < MULTIPLEX; y++) {
+            scan_block *b = &scan_table[y * scan_row_blocks];
+            uint32_t pins = 0;
+            volatile uint32_t *fifo;
+
+            b[0] = {&pio0_hw->rxf[0], &scan_dummy, 1, scan_ctrl(DREQ_PIO0_RX0, false, false, false)};
+
+            // Every pin has a status and control register, status is read only and drops the write.
+            if (Multiplex::GetRowPins(y, &pins)) {
+                for (uint32_t i = 0; i < Multiplex::HUB75::HUB75_ADDR_LEN; i++) {
+                    scan_address[y][2 * i] = 0;
+                    scan_address[y][(2 * i) + 1] = sio | (((pins >> (Multiplex::HUB75::HUB75_ADDR_BASE + i)) & 1 ? GPIO_OVERRIDE_HIGH : GPIO_OVERRIDE_LOW) << IO_BANK0_GPIO0_CTRL_OUTOVER_LSB);
+                }
+                b[1] = {scan_address[y], &iobank0_hw->io[Multiplex::HUB75::HUB75_ADDR_BASE].status, 2 * Multiplex::HUB75::HUB75_ADDR_LEN, scan_ctrl(DREQ_FORCE, true, true, false)};
+            }
+            else {
+                Multiplex::GetRowWord(y, &scan_address[y][0], &fifo);
+                b[1] = {scan_address[y], fifo, 1, scan_ctrl(DREQ_FORCE, false, false, false)};
+            }
+            b[2] = {&scan_header, &pio0_hw->txf[0], 1, scan_ctrl(DREQ_PIO0_TX0, false, false, false)};
+            b[3] = {nullptr, &pio0_hw->txf[0], line_length / 4, scan_ctrl(DREQ_PIO0_TX0, true, false, false)};
+            b[4] = {&scan_dummy, &scan_dummy, scan_blank, scan_ctrl(dma_get_timer_dreq(dma_timer), false, false, false)};
+            b[5] = {&scan_latch, &pio0_hw->irq_force, 1, scan_ctrl(DREQ_FORCE, false, false, false)};
+            b[6] = {nullptr, &pio0_hw->txf[0], (row_length - line_length) / 4, scan_ctrl(DREQ_PIO0_TX0, true, false, y == (MULTIPLEX - 1))};
+        }
+    }
+
+    // Points the row blocks at the front bank and the bitplanes of the profile
+    static void __not_in_flash_func(scan_load)() {
+        scan_header = get_profile_planes(profile) - 1;                              // Bitplanes
+
+        for (uint32_t y = 0; y < MULTIPLEX; y++) {
+            scan_block *b = &scan_table[y * scan_row_blocks];
+
+            b[3].read = buffer->get_line(y, profile);
+            b[6].read = buffer->get_line(y, profile + 1);
+            b[6].len = ((get_profile_planes(profile) - 1) * line_length) / 4;
+        }
+    }
+
+    // Replaces the bitplane count of the OE state machine (set x, planes - 1)
+    //  Only called while the OE state machine is pulsing the bitplanes of a row, it loads the count after the row.
+    static void __not_in_flash_func(arm_profile)() {
+        profile_armed = profile_next;
+        pio0->instr_mem[oe_offset + 1] = pio_encode_set(pio_x, get_profile_planes(profile_armed) - 1) | pio_encode_sideset(1, 1);
     }
 
     void __not_in_flash_func(send_line)(uint32_t row) {
-        dma_hw->ints0 = 1 << dma_chan[0];
-        pio_sm_put(pio0, 0, (1 << PWM_bits) - 1);
-        dma_channel_set_read_addr(dma_chan[1], &address_table[bank][row * ((1 << PWM_bits) + 2)], true);
+        pio_sm_put(pio0, 0, get_profile_planes(profile) - 1);                      // Bitplanes
+        dma_channel_transfer_from_buffer_now(dma_chan[0], buffer->get_line(row, profile), (get_profile_planes(profile) * line_length) / 4);
     }
 
     void __not_in_flash_func(dma_isr)() {
-        if (dma_channel_get_irq0_status(dma_chan[0])) {      
-            // Make sure the FIFO is empty 
-            //  We will have up to 1uS of delay at the end of every row. 
-            //      Display will be off during this time, which may reduce brightness.
-            //      Not factored into calculator!
-            constexpr uint32_t FIFO_delay = (uint32_t) 4000000U / ((uint32_t) round(SERIAL_CLOCK));
-            timer_hw->alarm[timer] = time_us_32() + FIFO_delay + 1;                 // Load timer
-            timer_hw->armed = 1 << timer;                                           // Kick off timer
-            state = 0;
+        // Only used by DMA_SCAN
+        if (DMA_SCAN && scan && dma_channel_get_irq0_status(dma_chan[0])) {        // Fire rate: REFRESH (Last row is still shifting)
+            uint8_t temp;
+            Buffer *p = Worker::get_front_buffer(&temp);
+
+            if (p != nullptr) {
+                buffer = p;
+                bank = temp;
+            }
+
+            // Last row is still being pulsed if its end of row word is not in the RX FIFO yet. (The last bitplane alone is much longer than this)
+            //  Otherwise the OE state machine may have loaded the count of the next row already, the profile waits for the next refresh.
+            if ((profile_next != profile) && pio_sm_is_rx_fifo_empty(pio0, 0)) {
+                arm_profile();
+                profile = profile_armed;
+            }
+
+            scan_load();
             dma_hw->intr = 1 << dma_chan[0];                                        // Clear the interrupt
+            dma_channel_set_read_addr(dma_chan[1], &scan_table[0], true);           // Restart, waits for the last row
         }
     }
 
-    void __not_in_flash_func(timer_isr)() {
-        static uint32_t rows = 0;
+    void __not_in_flash_func(pio_isr)() {
+        if (pio0_hw->ints0 & PIO_IRQ0_INTS_SM0_BITS) {                              // Verify who called this (Panel is already off)
+            timer_hw->alarm[timer] = time_us_32() + BLANK_TIME + 1;                 // Load timer (We don't care if it rolls over!)
+            timer_hw->armed = 1 << timer;                                           // Kick off timer
+            pio0_hw->irq = 1;                                                       // Clear the interrupt
+            
+            if (++rows >= MULTIPLEX) {                                              // Fire rate: MULTIPLEX * REFRESH (Note we now call 2 ISRs per fire, see DMA_SCAN)
+                uint8_t temp;
+                Buffer *p = Worker::get_front_buffer(&temp);
+                rows = 0;
+
+                if (p != nullptr) {
+                    buffer = p;
+                    bank = temp;
+                }
 
+                profile = profile_armed;
+                Matrix::frame();                                                    // Engine may switch algorithms after this ISR
+            }
+
+            Multiplex::SetRow(rows);
+            send_line(rows);                                                        // Kick off hardware, first line waits on latch_irq
+            state = 1;
+        }
+    }
+
+    void __not_in_flash_func(timer_isr)() {
         if (timer_hw->ints & (1 << timer)) {                                        // Verify who called this
             switch (state) {
-                case 0:
-                    gpio_set_mask(1 << Matrix::HUB75::HUB75_OE);                            // Turn off the panel (For MBI5124 this activates the low side anti-ghosting)
-                    timer_hw->alarm[timer] = time_us_32() + BLANK_TIME + 1;                 // Load timer (We don't care if it rolls over!)
-                    timer_hw->armed = 1 << timer;                                           // Kick off timer
-                    timer_hw->intr = 1 << timer;                                            // Clear the interrupt
-                    
-                    if (++rows >= MULTIPLEX) {                                              // Fire rate: MULTIPLEX * REFRESH (Note we now call 3 ISRs per fire)
-                        uint8_t temp;
-                        Buffer *p = Worker::get_front_buffer(&temp);
-                        rows = 0;
-
-                        if (p != nullptr) {
-                            buffer = p;
-                            bank = temp;
-                        }
-                    }
-                    
-                    Multiplex::SetRow(rows);
-                    state++;
-                    break;
-
                 case 1:
-                    gpio_clr_mask(1 << Matrix::HUB75::HUB75_OE);                    // Turn on the panel (Note software controls PWM/BCM)
-                    send_line(rows);                                                // Kick off hardware
+                    pio0_hw->irq_force = 1 << latch_irq;                            // Latch the first line (OE state machine turns on the panel)
                     state++;
+
+                    // Last row was started, the OE state machine loads the count again after it.
+                    if ((rows == (MULTIPLEX - 1)) && (profile_next != profile_armed))
+                        arm_profile();
+
                     timer_hw->intr = 1 << timer;                                    // Clear the interrupt
                     break;
                     
@@ -254,4 +448,17 @@ namespace Matrix {
             }
         }
     }
+
+    // Takes effect with the next refresh, the banks hold every bitplane.
+    bool set_profile(uint8_t p) {
+        if (p >= PROFILES)
+            return false;
+
+        profile_next = p;
+        return true;
+    }
+
+    uint8_t get_profiles() {
+        return PROFILES;
+    }
 }
@@ -0,0 +1,18 @@
+/* 
+ * File:   engine.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+// PWM and BCM in one image, switched by profile at a frame boundary. (See Matrix/engine.h)
+//  Profile 0 is PWM for video, profiles 1 to PROFILES are the BCM profiles for static content with depth.
+//  Formats of both are built from the same options, PWM_bits is the same for both. (See memory_format.h)
+#include "Matrix/engine.h"
+#include "Matrix/HUB75/PWM/algorithm.h"
+#include "Matrix/HUB75/BCM/algorithm.h"
+
+namespace Matrix {
+    typedef Engine<PWM::Algorithm, BCM::Algorithm> engine;
+}
+
+#include "Matrix/engine_api.h"
@@ -5,12 +5,13 @@
  */
 
 #include <algorithm>
+#include <type_traits>
 #include <stdint.h>
 #include "Matrix/HUB75/PWM/memory_format.h"
 #include "Matrix/matrix.h"
 #include "Serial/config.h"
 
-namespace Matrix::Calculator {
+namespace Matrix::PWM::Calculator {
     // Panel constants
     constexpr double max_clk_mhz = 25.0;
     constexpr uint8_t columns_per_driver = 16;
@@ -24,20 +25,38 @@ namespace Matrix::Calculator {
     constexpr uint8_t max_led_cap_pf = 18;
     constexpr uint8_t min_led_harmonics = 5;
 
+    // Display is off for the blank time of every row. (See matrix.cpp)
+    //  The first line of the row is shifted during the blank time, the end of row is signaled by PIO.
+    //      Blank time is extended if the first line takes longer to shift.
     static constexpr double get_refresh_overhead() {
+        const double first_line_us = (line_cycles * 1000000.0) / (2.0 * SERIAL_CLOCK);
         double refresh_overhead = 1000000.0 / (MULTIPLEX * MIN_REFRESH);
-        refresh_overhead /= refresh_overhead - BLANK_TIME;
+        refresh_overhead /= refresh_overhead - std::max((double) BLANK_TIME, first_line_us);
         return refresh_overhead;
     }
 
+    // Rows are scanned Table::scans times per PWM period, MIN_REFRESH is the scan refresh. (See matrix.cpp)
+    //  Every scan shifts Table::lines lines and the null line, the first line is shifted during the blank time.
+    //      The PWM period refresh is this divided by Table::scans.
+    static constexpr double get_effective_refresh() {
+        const double first_line_us = (line_cycles * 1000000.0) / (2.0 * SERIAL_CLOCK);
+        const double row_us = std::max((double) BLANK_TIME, first_line_us) + ((Table::lines * line_cycles * 1000000.0) / (2.0 * SERIAL_CLOCK));
+        return 1000000.0 / (MULTIPLEX * row_us);
+    }
+
     static constexpr void is_clk_valid() {
-        constexpr uint64_t temp = (COLUMNS / columns_per_driver) * max_impedance * fanout_per_clk * min_harmonics * max_par_cap_pf;
+        // CLK is shared by every chain
+        constexpr uint64_t temp = CHAINS * (COLUMNS / columns_per_driver) * max_impedance * fanout_per_clk * min_harmonics * max_par_cap_pf;
         constexpr double hz_limit = BYPASS_FANOUT ? max_clk_mhz * 1000000.0 : 
             std::min(max_clk_mhz, (double) (1000000.0 / (temp * 1.0))) * 1000000.0;
-        constexpr double clk_hz = hz_limit / (MIN_REFRESH * get_refresh_overhead() * COLUMNS * MULTIPLEX * ((1 << PWM_bits) + 1));
+        constexpr double clk_hz = hz_limit / (MIN_REFRESH * get_refresh_overhead() * line_columns * MULTIPLEX * (Table::lines + 1));
         
         static_assert(SERIAL_CLOCK <= hz_limit, "Serial clock is too high");
         static_assert(clk_hz >= 1.0, "Configuration is not possible");
+        static_assert((Table::scans == 1) || (get_effective_refresh() >= MIN_REFRESH), "Sub periods can not be shifted at MIN_REFRESH");
+        
+        // Gamma lines are held longer than a shift, the row must still fit in the row period. (See step_table in memory_format.h)
+        static_assert((PWM_GAMMA == 1.0) || ((std::max(blank_cycles, (double) line_cycles) + step_table.step_end[1 << PWM_bits]) <= period_cycles), "Gamma lines do not fit in MIN_REFRESH");
     }
 
     static constexpr void is_brightness_valid() {
@@ -77,8 +96,8 @@ namespace Matrix::Calculator {
         // This is depends on panel implementation however the fanout and par cap in matrix limit the max size.
         //  Technically capable of more pixels with multiplexing, if we reduce refresh and contrast.
         //  Picked numbers to simplify support and define limits.
-        static_assert(COLUMNS <= 255, "COLUMNS more than 1024 is not recommended, but we only support up to 255");
-        static_assert((2 * MULTIPLEX * COLUMNS) <= 8192, "More than 8192 pixels is not recommended");
+        static_assert(COLUMNS <= 1024, "COLUMNS more than 1024 is not recommended");
+        static_assert((2 * MULTIPLEX * COLUMNS * CHAINS) <= 8192, "More than 8192 pixels is not recommended");
 
         // This is the limit observed in testing and from most panel specifications.
         static_assert((MULTIPLEX * (1 << PWM_bits)) <= (4 * 1024), "The current LED grayscale is not supported");
@@ -92,11 +111,32 @@ namespace Matrix::Calculator {
         //
         //  The sum off all memory usage for serial frames and LED buffers must not exceed 192KB.
         //      64KB is reserved for code and 8KB is reserved for stack/heap for both cores.
-        static_assert((2 * MULTIPLEX * COLUMNS * sizeof(Serial::DEFINE_SERIAL_RGB_TYPE)) <= Serial::payload_size, "The current frame size is not supported");
-        static_assert((MULTIPLEX * COLUMNS * (1 << PWM_bits)) <= Serial::max_framebuffer_size, "The current buffer size is not supported");
-        static_assert(MIN_REFRESH > 2 * FPS, "Refresh rate must be higher than twice the number of frames per second");
+        static_assert((2 * MULTIPLEX * COLUMNS * CHAINS * sizeof(Serial::DEFINE_SERIAL_RGB_TYPE)) <= Serial::payload_size, "The current frame size is not supported");
+        //  Identical lines share a slot, worst case is PWM_lines slots per row. (See Buffer.cpp)
+        static_assert(((((MULTIPLEX * (PWM_lines + 1) * sizeof(uint16_t)) + 3) & ~3) + (MULTIPLEX * row_length)) <= Serial::max_framebuffer_size, "The current buffer size is not supported");
+        static_assert((MIN_REFRESH / Table::scans) > 2 * FPS, "PWM period refresh rate must be higher than twice the number of frames per second");
+
+        // Scans split the lines evenly (See Table in memory_format.h)
+        static_assert((Table::scans >= 1) && ((Table::scans & (Table::scans - 1)) == 0), "SUB_PERIODS must be a power of two");
+        static_assert(Table::scans <= (1 << PWM_bits), "SUB_PERIODS must not exceed the PWM period");
+
+        // Split point between the thermometer lines and the bitplanes (HYBRID)
+        //  Every low bit doubles the thermometer lines, every high bit adds one bitplane.
+        static_assert(Table::low_bits >= 1, "PWM_LOW_BITS must be at least one");
+        static_assert(Table::low_bits <= PWM_bits, "PWM_LOW_BITS must not exceed the PWM bits");
+
+        // SPWM and HYBRID are scanned with the address table and interrupts, ROW_DMA shifts the PWM row as one transfer.
+        static_assert(std::is_same<Table, PWM_table>::value || (!ROW_DMA && !DMA_SCAN), "ROW_DMA and DMA_SCAN are only supported by PWM");
+
+        // Line durations are carried by the hold word of every line (See memory_format.h)
+        static_assert((PWM_GAMMA == 1.0) || ROW_DMA, "PWM_GAMMA requires ROW_DMA");
+        static_assert(PWM_GAMMA > 0, "PWM_GAMMA must be positive");
+        static_assert((PWM_GAMMA == 1.0) || (COLOR_GAMMA == 1.0), "PWM_GAMMA and COLOR_GAMMA would apply gamma twice");
 
         // Qualify Worker Performance
-        static_assert(((2 * MULTIPLEX * COLUMNS * 3 * 2 * FPS * (1 << PWM_bits)) / 1000000.0) <= 1.5, "CPU is only capable of so many operations per second.");
+        //  Rows converted by core 0 between serial polls are not credited, this has not been measured. (See Matrix::Worker::assist)
+        //  HYBRID sets PWM_lines lines per channel, this does not depend on the image.
+        constexpr uint32_t lines = (BCM_bits != 0) ? PWM_lines : (1 << PWM_bits);
+        static_assert(((2 * MULTIPLEX * COLUMNS * CHAINS * 3 * 2 * FPS * lines) / 1000000.0) <= 1.5, "CPU is only capable of so many operations per second.");
     }
 }
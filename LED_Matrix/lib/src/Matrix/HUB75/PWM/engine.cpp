@@ -0,0 +1,15 @@
+/* 
+ * File:   engine.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+// PWM alone, SPWM and HYBRID link this too. (See CMakeLists.txt)
+#include "Matrix/engine.h"
+#include "Matrix/HUB75/PWM/algorithm.h"
+
+namespace Matrix {
+    typedef Engine<PWM::Algorithm> engine;
+}
+
+#include "Matrix/engine_api.h"
@@ -9,166 +9,505 @@
 #include <string.h>
 #include <math.h>
 #include "pico/multicore.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
 #include "Serial/config.h"
 #include "Matrix/matrix.h"
+#include "Matrix/engine.h"
 #include "Matrix/HUB75/PWM/memory_format.h"
+#include "Matrix/HUB75/PWM/algorithm.h"
 #include "Matrix/helper.h"
+#include "Matrix/color.h"
+#include "Matrix/dot.h"
+#include "Matrix/dither.h"
+#include "Matrix/map.h"
+#include "Matrix/bitplane.h"
+#include "CRC/CRC.h"
 #include "Matrix/HUB75/PWM/PWM_worker.h"
 
-namespace Matrix::Worker {
-    Matrix::Buffer buf[Serial::num_framebuffers];
-    static uint8_t bank = 0;
-    static volatile uint8_t bank_vsync = 0;
-    static volatile bool vsync = false;
-
-    template <typename T> PWM_worker<T>::PWM_worker() {
-        for (uint32_t i = 0; i < (1 << PWM_bits); i++) {
-            for (uint32_t j = 0; j < 6; j++) {
-                for (uint32_t k = 0; k < PWM_worker::size; k++) {
-                    index_table[i][j][k].l = 0;
+namespace Matrix::PWM {
+    extern address_table_t address_table[Serial::num_framebuffers];
+    extern volatile uint8_t null_table[line_length];
+}
+
+namespace Matrix::PWM::Worker {
+    Buffer buf[Serial::num_framebuffers];
+    static volatile Matrix::Worker::Statistics &stats = Matrix::Worker::stats;
+    static APP::Color<PWM_bits> &color = Matrix::Worker::color<PWM_bits>;     // Color stage (See Matrix/color.h)
+
+    // Triple buffering (Banks are never copied, only their roles are exchanged)
+    //  bank_front is displayed, bank_ready holds the newest complete frame and bank is written by the worker.
+    //      Worker publishes by swapping bank and bank_ready. A frame still waiting in bank_ready is dropped. (Latest frame wins)
+    //      ISR takes bank_ready at row 0 by swapping it with bank_front. Otherwise the displayed frame is repeated.
+    //  Worker and Matrix ISRs share core 1 (See main.cpp), the worker only masks interrupts for the swap.
+    //      Neither side ever waits for the other.
+    static uint8_t bank = 2;
+    static uint8_t bank_last = 0;                   // Last published bank (Source for copied rows)
+    static volatile uint8_t bank_ready = 1;
+    static volatile uint8_t bank_front = 0;
+    static volatile bool ready_fresh = false;
+    static volatile uint32_t ready_time = 0;
+
+    // Rows of a packet are shared by both cores (See assist)
+    //  RP2040 (Cortex-M0+) has no exclusive load/store, a hardware spinlock guards the row counters.
+    //      Spinlock is only held for a few instructions, neither core can stall the other.
+    enum class ROW_ACTION { SKIP, COPY, CONVERT };
+    static spin_lock_t *volatile row_lock = nullptr;
+    static Serial::packet *volatile row_packet = nullptr;
+    static volatile uint8_t row_next = 0;
+    static volatile uint8_t row_done = 0;
+    static uint8_t row_src = 0;
+    static ROW_ACTION row_action[MULTIPLEX];
+    static bool (*volatile assist_row)() = nullptr;
+
+    // Hands the finished bank to the ISR and recycles the stale one
+    static void __not_in_flash_func(publish)() {
+        uint32_t irq = save_and_disable_interrupts();
+        const uint8_t stale = bank_ready;
+
+        if (ready_fresh)
+            stats.frames_dropped++;
+
+        bank_ready = bank;
+        ready_time = time_us_32();
+        ready_fresh = true;
+        restore_interrupts(irq);
+
+        bank_last = bank;
+        bank = stale;
+    }
+
+    PWM_worker::PWM_worker() {
+        reset();
+    }
+
+    void PWM_worker::reset() {
+        for (uint32_t i = 0; i < Serial::num_framebuffers; i++)
+            valid[i] = false;
+    }
+
+    inline uint16_t PWM_worker::get_value(uint16_t v, uint8_t c, const uint8_t *k, uint8_t t) {
+        return APP::Dither<PWM_bits>::apply(APP::Dot::apply(color.get(c, v), k[c]), t);
+    }
+
+    // LSD radix sort of the drop entries by value (digit_bits per pass)
+    //  Two passes cover 12 bits, the count table does not grow with PWM_bits.
+    inline uint32_t *PWM_worker::sort(uint32_t n, uint32_t core) {
+        static_assert(PWM_bits <= (2 * digit_bits), "Radix sort is two passes of digit_bits, PWM_bits must be 12 or less");
+
+        uint32_t *src = drop[core];
+        uint32_t *dst = temp[core];
+        uint16_t *bucket = count[core];
+
+        for (uint32_t shift = 16; shift < (16U + PWM_bits); shift += digit_bits) {
+            uint16_t sum = 0;
+
+            for (uint32_t i = 0; i < (1 << digit_bits); i++)
+                bucket[i] = 0;
+
+            for (uint32_t i = 0; i < n; i++)
+                bucket[(src[i] >> shift) & ((1 << digit_bits) - 1)]++;
+
+            for (uint32_t i = 0; i < (1 << digit_bits); i++) {
+                uint16_t c = bucket[i];
+                bucket[i] = sum;
+                sum += c;
+            }
+
+            for (uint32_t i = 0; i < n; i++)
+                dst[bucket[(src[i] >> shift) & ((1 << digit_bits) - 1)]++] = src[i];
+
+            std::swap(src, dst);
+        }
+
+        return src;
+    }
+
+    // Bucket sweep: (Replaces lookup table of 2^PWM_bits lines per value)
+    //  Line 0 has every channel with a non-zero value on.
+    //  Line i is line i - 1 with the channels whose value is i turned off.
+    //      Line only changes at a drop point, so only one slot is written per distinct value.
+    //      Lines past the largest value are blank and use null_table. (See set_table)
+    //      This is O(COLUMNS + distinct values * COLUMNS / 4) with word copies.
+    //  Scratch memory is per core, both cores may convert rows at the same time.
+    inline void PWM_worker::set_row(uint8_t y, Serial::packet *p) {
+        const uint32_t core = get_core_num();
+        uint16_t *levels = buf[bank].get_levels(y);
+        line_t *line = (line_t *) (buf[bank].get_line(y, 0) + Buffer::get_column_offset());
+        uint32_t n = 0;
+
+        for (uint16_t x = 0; x < COLUMNS; x++) {
+            line_t c = 0;
+
+            for (uint8_t chain = 0; chain < CHAINS; chain++) {
+                const uint16_t r = y + (chain * 2 * MULTIPLEX);
+                const uint32_t m[2] = { APP::Map::get(r, x), APP::Map::get(r + MULTIPLEX, x) };
+                const Serial::pixel *s[2] = { APP::Map::pixel(p, m[0]), APP::Map::pixel(p, m[1]) };
+                const uint8_t *dot[2] = { APP::Dot::get(m[0]), APP::Dot::get(m[1]) };
+                const uint8_t dither[2] = { APP::Dither<PWM_bits>::get(r, x), APP::Dither<PWM_bits>::get(r + MULTIPLEX, x) };
+                uint16_t v[6] = { 
+                    get_value(s[0]->red, 0, dot[0], dither[0]), get_value(s[0]->green, 1, dot[0], dither[0]), get_value(s[0]->blue, 2, dot[0], dither[0]),
+                    get_value(s[1]->red, 0, dot[1], dither[1]), get_value(s[1]->green, 1, dot[1], dither[1]), get_value(s[1]->blue, 2, dot[1], dither[1])
+                };
+
+                for (uint32_t k = 0; k < 6; k++) {
+                    if (v[k] != 0) {
+                        c |= 1 << ((6 * chain) + k);
+                        drop[core][n++] = (v[k] << 16) | (x << 5) | ((6 * chain) + k);
+                    }
                 }
             }
+
+            line[x] = c;
         }
 
-        build_index_table();
+        uint32_t *d = sort(n, core);
+        uint32_t j = 0;
+        uint16_t slots = 0;
+
+        while (j < n) {
+            const uint16_t level = d[j] >> 16;
+            uint32_t k = j;
+
+            while ((k < n) && ((d[k] >> 16) == level))
+                k++;
+
+            // Next slot is only needed if something is still on
+            if (k < n) {
+                line_t *prev = line;
+                line = (line_t *) (buf[bank].get_line(y, slots + 1) + Buffer::get_column_offset());
+                memcpy(line, prev, COLUMNS * sizeof(line_t));
+
+                for (; j < k; j++)
+                    line[(d[j] >> 5) & 0x7FF] &= ~(1 << (d[j] & 0x1F));
+            }
+
+            j = k;
+            levels[++slots] = level;
+        }
+
+        levels[0] = slots;
+        set_table(y);
     }
 
-    template <typename T> inline SIMD::SIMD_QUARTER<T> *PWM_worker<T>::get_table(uint16_t v, uint8_t i) {
-        constexpr uint32_t div = std::max((uint32_t) Serial::range_high / 1 << PWM_bits, (uint32_t) 1);
-        constexpr uint32_t mul = std::max((uint32_t) 1 << PWM_bits / Serial::range_high, (uint32_t) 1);
+    // Thermometer lines and bitplanes: (HYBRID, replaces the sort)
+    //  Slot t has every channel whose low bits are greater than t on.
+    //  Slot low_lines + i has every channel with bit Table::low_bits + i set on.
+    //      Bitplanes are transposed four columns at a time like BCM. (See Matrix/bitplane.h)
+    //      Slots and levels do not depend on the image, set_table repeats bitplane i for 2^(low_bits + i) lines.
+    //      This is O(COLUMNS * PWM_lines) and does not depend on the image.
+    inline void PWM_worker::set_planes(uint8_t y, Serial::packet *p) {
+        uint16_t *levels = buf[bank].get_levels(y);
+
+        for (uint8_t chain = 0; chain < CHAINS; chain++) {
+            const uint16_t r = y + (chain * 2 * MULTIPLEX);
+
+            for (uint16_t x = 0; x < COLUMNS; x += 4) {
+                const uint32_t n = std::min(4, COLUMNS - x);        // Last group is short if COLUMNS is not a multiple of four
+                uint16_t high[4][6] = {};
+                uint32_t c[PWM_lines] = {};
+
+                for (uint32_t j = 0; j < n; j++) {
+                    const uint32_t m[2] = { APP::Map::get(r, x + j), APP::Map::get(r + MULTIPLEX, x + j) };
+                    const Serial::pixel *s[2] = { APP::Map::pixel(p, m[0]), APP::Map::pixel(p, m[1]) };
+                    const uint8_t *dot[2] = { APP::Dot::get(m[0]), APP::Dot::get(m[1]) };
+                    const uint8_t dither[2] = { APP::Dither<PWM_bits>::get(r, x + j), APP::Dither<PWM_bits>::get(r + MULTIPLEX, x + j) };
+                    const uint16_t v[6] = { 
+                        get_value(s[0]->red, 0, dot[0], dither[0]), get_value(s[0]->green, 1, dot[0], dither[0]), get_value(s[0]->blue, 2, dot[0], dither[0]),
+                        get_value(s[1]->red, 0, dot[1], dither[1]), get_value(s[1]->green, 1, dot[1], dither[1]), get_value(s[1]->blue, 2, dot[1], dither[1])
+                    };
+
+                    for (uint32_t k = 0; k < 6; k++) {
+                        for (uint32_t t = 0; t < (v[k] & low_lines); t++)
+                            c[t] |= 1 << ((j * 8) + k);
 
-        v = v * mul / div;
-        //v %= (1 << PWM_bits);
-        return index_table[v][i];
+                        high[j][k] = v[k] >> Table::low_bits;
+                    }
+                }
+
+                APP::get_planes<BCM_bits>(high, &c[low_lines]);
+
+                for (uint32_t i = 0; i < PWM_lines; i++) {
+                    if (n == 4)
+                        buf[bank].set_word(y, i, x, chain, c[i]);
+                    else
+                        for (uint32_t j = 0; j < n; j++)
+                            buf[bank].set_value(y, i, x + j, chain, (c[i] >> (j * 8)) & 0xFF);
+                }
+            }
+        }
+
+        for (uint16_t t = 0; t < low_lines; t++)
+            levels[t + 1] = t + 1;
+
+        for (uint16_t i = 0; i < BCM_bits; i++)
+            levels[low_lines + i + 1] = (1 << (Table::low_bits + i + 1)) - 1;
+
+        levels[0] = PWM_lines;
+        set_table(y);
     }
 
-    // Tricks: (Branch is index into vector via PC)
-    //  1. Use types
-    //  2. Remove if with calculations (multiply and accumulate)
-    //      2.1 SIMD may help
-    //      2.2 Matrix operations may help
-    //  3. Remove if with LUT (needs good cache)
-    //      3.1 Matrix operations may help
-    template <typename T> inline void PWM_worker<T>::set_pixel(uint8_t x, uint8_t y, uint16_t r0, uint16_t g0, uint16_t b0, uint16_t r1, uint16_t g1, uint16_t b1) {    
-        SIMD::SIMD_QUARTER<T> *c[6] = { get_table(r0, 0), get_table(g0, 1), get_table(b0, 2), get_table(r1, 3), get_table(g1, 4), get_table(b1, 5) };
-    
-        for (uint32_t i = 0; i < (1 << PWM_bits); i += SIMD::SIMD_QUARTER<T>::size()) {
-            // Superscalar Operation (forgive the loads)
-            SIMD::SIMD_QUARTER<T> p = *c[0] | *c[1] | *c[2] | *c[3] | *c[4] | *c[5];
+    // Points the DMA control blocks of a row at the slots of the row.
+    //  Line i uses the first slot whose level is greater than i.
+    //      Line i is placed by the address table policy. (See Table in memory_format.h)
+    // With ROW_DMA there are no control blocks, the row is shifted as is. (See matrix.cpp)
+    //  Slot j is held for the lines up to its level, the blank line after the last slot for the rest.
+    //      Hold is the time of these lines less the shift of the next line. (See step_table in memory_format.h)
+    //      Blank line and end line move with the number of slots in use.
+    inline void PWM_worker::set_table(uint8_t y) {
+        const uint16_t *levels = buf[bank].get_levels(y);
+
+        if constexpr (ROW_DMA) {
+            uint16_t start = 0;
+            uint8_t *line;
+
+            for (uint16_t j = 0; j < levels[0]; j++) {
+                line = buf[bank].get_line(y, j);
+                *((uint32_t *) line) = line_columns - 1;
+                *((uint32_t *) (line + line_length - 4)) = step_table.step_end[levels[j + 1]] - step_table.step_end[start] - line_cycles;
+                start = levels[j + 1];
+            }
+
+            line = buf[bank].get_line(y, levels[0]);
+            memset(line, 0, line_length + end_length);
+            *((uint32_t *) line) = line_columns - 1;
+            *((uint32_t *) (line + line_length - 4)) = step_table.step_end[1 << PWM_bits] - step_table.step_end[start] - line_cycles;
+            *((uint32_t *) (line + line_length)) = end_columns - 1;
+        }
+        else {
+            uint16_t j = 0;
+
+            for (uint32_t i = 0; i < (1 << PWM_bits); i++) {
+                volatile address_entry *entry = &address_table[bank][((Table::get_scan(i) * MULTIPLEX) + y) * table_entries];
 
-            // Hopefully the compiler will sort this out. (Inlining set_value)
-            for (uint32_t j = 0; (j < (SIMD::SIMD_QUARTER<T>::size())) && ((i + j) < (1 << PWM_bits)); j++)
-                buf[bank].set_value(y, i + j, x + 1, p.v[j]);
+                while ((j < levels[0]) && (levels[j + 1] <= i))
+                    j++;
 
-            // Superscalar operation
-            for (uint32_t j = 0; j < 6; j++)
-                ++c[j];
+                entry[Table::get_line(i)].data = (j < levels[0]) ? buf[bank].get_line(y, j) : null_table;
+            }
         }
     }
 
-    template <typename T> inline void PWM_worker<T>::build_index_table() {
-        for (uint32_t i = 0; i < (1 << PWM_bits); i++) {
-            for (uint32_t j = 0; j < i; j++)
-                for (uint8_t k = 0; k < 6; k++)
-                    index_table[i][k][j / SIMD::SIMD_QUARTER<T>::size()].v[j % SIMD::SIMD_QUARTER<T>::size()] = 1 << k;
+    inline uint32_t PWM_worker::get_hash(uint8_t y, Serial::packet *p) {
+        uint32_t checksum = 0xFFFFFFFF;
+
+        // Rows y and y + MULTIPLEX of every chain
+        for (uint32_t i = 0; i < (2 * CHAINS); i++) {
+            const uint16_t r = y + (i * MULTIPLEX);
+
+            if constexpr (APP::Map::identity) {
+                const uint8_t *row = (const uint8_t *) p->data[r];
+
+                for (uint32_t j = 0; j < sizeof(p->data[r]); j++)
+                    checksum = CRC::crc32(checksum, row[j]);
+            }
+            else {
+                // Pixels gathered by the row (See Matrix/map.h)
+                for (uint16_t x = 0; x < COLUMNS; x++) {
+                    const uint8_t *px = (const uint8_t *) APP::Map::pixel(p, APP::Map::get(r, x));
+
+                    for (uint32_t j = 0; j < sizeof(Serial::pixel); j++)
+                        checksum = CRC::crc32(checksum, px[j]);
+                }
+            }
         }
+
+        return ~checksum;
+    }
+
+    inline void PWM_worker::copy_row(uint8_t y, Buffer *src) {
+        const uint16_t *levels = src->get_levels(y);
+
+        memcpy(buf[bank].get_levels(y), levels, (levels[0] + 1) * sizeof(uint16_t));
+        memcpy(buf[bank].get_line(y, 0), src->get_line(y, 0), levels[0] * Buffer::get_line_length());
+        set_table(y);
     }
 
-    template <typename T> inline void PWM_worker<T>::process_packet(Serial::packet *p) {
+    // Lines which did not need a slot of their own (Read from the finished bank only)
+    inline void PWM_worker::update_statistics() {
         for (uint8_t y = 0; y < MULTIPLEX; y++) {
-            for (uint16_t x = 0; x < COLUMNS; x++) {
-                    set_pixel(x, y, p->data[y][x].red, p->data[y][x].green, p->data[y][x].blue, p->data[y + MULTIPLEX][x].red, p->data[y + MULTIPLEX][x].green, p->data[y + MULTIPLEX][x].blue);
-            }
+            const uint16_t *levels = buf[bank].get_levels(y);
+            const uint16_t last = (levels[0] != 0) ? levels[levels[0]] : 0;
+
+            stats.lines_blank += (1 << PWM_bits) - last;
+            stats.lines_shared += last - levels[0];
+        }
+    }
+
+    // Claims the next row of the current packet and processes it.
+    //  Returns false if there is nothing left to claim.
+    inline bool PWM_worker::process_row() {
+        Serial::packet *p = nullptr;
+        uint8_t y = 0;
+        uint32_t irq = spin_lock_blocking(row_lock);
+
+        if ((row_packet != nullptr) && (row_next < MULTIPLEX)) {
+            p = row_packet;
+            y = row_next++;
         }
 
-        while (vsync) {
-            // Block
+        spin_unlock(row_lock, irq);
+
+        if (p == nullptr)
+            return false;
+
+        switch (row_action[y]) {
+            case ROW_ACTION::COPY:
+                copy_row(y, &buf[row_src]);
+                break;
+            case ROW_ACTION::CONVERT:
+                if constexpr (BCM_bits != 0)
+                    set_planes(y, p);
+                else
+                    set_row(y, p);
+                break;
+            default:
+                break;
         }
 
-        vsync = true;
-        bank = (bank + 1) % Serial::num_framebuffers;
-    }   
+        irq = spin_lock_blocking(row_lock);
+        row_done++;
+        spin_unlock(row_lock, irq);
+        __sev();
+
+        return true;
+    }
+
+    // Dirty row tracking:
+    //  Row pairs (y and y + MULTIPLEX) are hashed and compared against the bank being replaced and the last published bank.
+    //      Bank being replaced already holds the row: nothing to do
+    //      Last published bank holds the row: copy the lines
+    //      Otherwise convert the row
+    //  If every row matches the last published bank the frame is dropped, it is already on the way to the display.
+    inline void PWM_worker::process_packet(Serial::packet *p) {
+        // New color or dot correction tables change every row
+        if (color.update() | APP::Dot::update())
+            reset();
+
+        const uint8_t prev = bank_last;
+        uint32_t h[MULTIPLEX];
+        bool dirty = !valid[prev];
 
-    template <typename T> inline void PWM_worker<T>::save_buffer(Matrix::Buffer *p) {
         for (uint8_t y = 0; y < MULTIPLEX; y++) {
-            for (uint32_t i = 0; i < (1 << PWM_bits); i++) {
-                uint8_t *p0 = buf[bank].get_line(y, i);
-                uint8_t *p1 = p->get_line(y, i);
+            h[y] = get_hash(y, p);
+            dirty |= h[y] != hash[prev][y];
+        }
 
-                for (uint8_t x = 0; x < Matrix::Buffer::get_line_length(); x++) {
-                    p0[x] = p1[x];
-                }
+        if (!dirty) {
+            stats.frames_skipped++;
+            return;
+        }
+
+        for (uint8_t y = 0; y < MULTIPLEX; y++) {
+            if (valid[bank] && (h[y] == hash[bank][y])) {
+                row_action[y] = ROW_ACTION::SKIP;
+                stats.rows_skipped++;
+            }
+            else if (valid[prev] && (h[y] == hash[prev][y])) {
+                row_action[y] = ROW_ACTION::COPY;
+                stats.rows_copied++;
             }
+            else {
+                row_action[y] = ROW_ACTION::CONVERT;
+                stats.rows_converted++;
+            }
+
+            hash[bank][y] = h[y];
         }
 
-        while (vsync) {
-            // Block
+        uint32_t irq = spin_lock_blocking(row_lock);
+        row_src = prev;
+        row_next = 0;
+        row_done = 0;
+        row_packet = p;
+        spin_unlock(row_lock, irq);
+        __sev();
+
+        while (process_row()) {
+            // Core 0 may take rows between polls
         }
 
-        vsync = true;
-        bank = (bank + 1) % Serial::num_framebuffers;
-    }    
-    
-    template <typename T> inline static void worker_internal() {
-        static PWM_worker<T> w;
-        
-        while(1) {
-            switch (APP::multicore_fifo_pop_blocking_inline()) {
-                case 0:
-                    {
-                        Serial::packet *p = (Serial::packet *) APP::multicore_fifo_pop_blocking_inline();
-                        w.process_packet(p);
-                    }
-                    break;
-                case 1:
-                    {
-                        Matrix::Buffer *p = (Matrix::Buffer *) APP::multicore_fifo_pop_blocking_inline();
-                        w.save_buffer(p);
-                    }
-                    break;
-                default:
-                    break;
-            }
+        while (row_done < MULTIPLEX) {
+            __wfe();
         }
+
+        update_statistics();
+        valid[bank] = true;
+
+        publish();
     }
 
-    void work() {
-        // Currently we only support 8-bit port
-        worker_internal<uint8_t>();
+    inline void PWM_worker::save_buffer(Buffer *p) {
+        valid[bank] = false;
+
+        for (uint8_t y = 0; y < MULTIPLEX; y++) {
+            copy_row(y, p);
+        }
+
+        update_statistics();
+
+        publish();
+    }    
+    
+    static PWM_worker worker;
+    static_assert(sizeof(worker) <= Algorithm::scratch_size, "Algorithm::scratch_size does not cover the PWM worker (See algorithm.h)");
+
+    // Worker is shared with core 0 from here on (See assist)
+    void start() {
+        row_lock = spin_lock_init(spin_lock_claim_unused(true));
+        assist_row = []() { return worker.process_row(); };
     }
 
-    void __not_in_flash_func(process)(Serial::packet *buffer) {
-        APP::multicore_fifo_push_blocking_inline(0);
-        APP::multicore_fifo_push_blocking_inline((uint32_t) buffer);
+    // Banks of another algorithm were displayed in between. (See Matrix/engine.h)
+    void reset() {
+        worker.reset();
     }
 
-    void __not_in_flash_func(process)(Matrix::Buffer *buffer) {
-        APP::multicore_fifo_push_blocking_inline(1);
-        APP::multicore_fifo_push_blocking_inline((uint32_t) buffer);
+    void process_packet(Serial::packet *p) {
+        worker.process_packet(p);
     }
 
-    Matrix::Buffer *__not_in_flash_func(get_front_buffer)() {
-        Matrix::Buffer *result = nullptr;
+    void save_buffer(Matrix::Buffer *p) {
+        worker.save_buffer(static_cast<Buffer *>(p));
+    }
 
-        if (vsync) {
-            result = &buf[bank_vsync];
-            bank_vsync = (bank_vsync + 1) % Serial::num_framebuffers;
-            vsync = false;
-        }
+    // Converts at most one row per call, this bounds the polling latency of core 0.
+    void __not_in_flash_func(assist)() {
+        bool (*f)() = assist_row;
 
-        return result;
+        if (f != nullptr)
+            f();
     }
 
-    Matrix::Buffer *__not_in_flash_func(get_front_buffer)(uint8_t *id) {
-        Matrix::Buffer *result = nullptr;
+    // Called from the timer ISR at row 0
+    //  Returns the newest complete bank, or nullptr if the displayed bank is still the newest.
+    //      id always receives the displayed bank.
+    Buffer *__not_in_flash_func(get_front_buffer)(uint8_t *id) {
+        Buffer *result = nullptr;
+
+        if (ready_fresh) {
+            const uint8_t front = bank_front;
+            const uint32_t latency = time_us_32() - ready_time;
+
+            bank_front = bank_ready;
+            bank_ready = front;
+            ready_fresh = false;
 
-        if (id != nullptr && vsync) {
-            result = &buf[bank_vsync];
-            *id = bank_vsync;
-            bank_vsync = (bank_vsync + 1) % Serial::num_framebuffers;
-            vsync = false;
+            stats.swap_latency_us = latency;
+            stats.swap_latency_max_us = std::max((uint32_t) stats.swap_latency_max_us, latency);
+            result = &buf[bank_front];
         }
+        else
+            stats.frames_repeated++;
+
+        if (id != nullptr)
+            *id = bank_front;
 
         return result;
     }
+
+    // Tables are taken before the next frame is converted. (See Matrix/color.h)
+    bool set_color(const uint16_t *table) {
+        return color.load(table);
+    }
 }
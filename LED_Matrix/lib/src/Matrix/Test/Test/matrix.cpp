@@ -32,7 +32,16 @@ namespace Matrix {
         // Do nothing
     }
 
+    void __not_in_flash_func(pio_isr)() {
+        // Do nothing
+    }
+
     void __not_in_flash_func(timer_isr)() {
         // Do nothing
     }
+
+    // Only the configuration is supported. (Profile 0)
+    bool set_profile(uint8_t profile) {
+        return profile == 0;
+    }
 }
@@ -20,7 +20,21 @@ namespace Matrix::Worker {
         }
     }
 
-    void __not_in_flash_func(process)(void *arg) {
+    void __not_in_flash_func(assist)() {
+        // Nothing to share
+    }
+
+    // Blocks until the FIFO has room, the frame is never rejected.
+    bool __not_in_flash_func(process)(void *arg) {
         APP::multicore_fifo_push_blocking_inline((uint32_t) arg);
+        return true;
+    }
+
+    bool set_color(const uint16_t *table) {
+        return false;
+    }
+
+    bool set_dot(uint16_t page, const uint8_t *data) {
+        return false;
     }
 }
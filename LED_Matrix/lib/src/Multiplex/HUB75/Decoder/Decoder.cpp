@@ -22,4 +22,15 @@ namespace Multiplex {
         gpio_clr_mask(mask << Multiplex::HUB75::HUB75_ADDR_BASE);
         gpio_set_mask((row & mask) << Multiplex::HUB75::HUB75_ADDR_BASE);
     }
+
+    bool GetRowPins(int row, uint32_t *pins) {
+        int mask = (1 << Multiplex::HUB75::HUB75_ADDR_LEN) - 1;
+        *pins = (row & mask) << Multiplex::HUB75::HUB75_ADDR_BASE;
+        return true;
+    }
+
+    // Rows are static pin levels, there is no state machine to push into.
+    bool GetRowWord(int row, uint32_t *word, volatile uint32_t **fifo) {
+        return false;
+    }
 }
@@ -20,6 +20,16 @@ namespace Multiplex {
     void __not_in_flash_func(SetRow)(int row) {
         int mask = (1 << Multiplex::HUB75::HUB75_ADDR_LEN) - 1;
         gpio_clr_mask(0x1F << Multiplex::HUB75::HUB75_ADDR_BASE);
-        gpio_set_mask((row % Multiplex::HUB75::HUB75_ADDR_LEN) + Multiplex::HUB75::HUB75_ADDR_BASE);
+        gpio_set_mask(1 << ((row % Multiplex::HUB75::HUB75_ADDR_LEN) + Multiplex::HUB75::HUB75_ADDR_BASE));
+    }
+
+    bool GetRowPins(int row, uint32_t *pins) {
+        *pins = 1 << ((row % Multiplex::HUB75::HUB75_ADDR_LEN) + Multiplex::HUB75::HUB75_ADDR_BASE);
+        return true;
+    }
+
+    // Rows are static pin levels, there is no state machine to push into.
+    bool GetRowWord(int row, uint32_t *word, volatile uint32_t **fifo) {
+        return false;
     }
 }
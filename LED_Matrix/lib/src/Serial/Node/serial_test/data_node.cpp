@@ -16,7 +16,7 @@ namespace Serial::Node::Data {
         static uint8_t buffer = 0;
         
         for (uint16_t x = 0; x < Matrix::COLUMNS; x++) {
-            for (uint8_t y = 0; y < (2 * Matrix::MULTIPLEX); y++) {
+            for (uint8_t y = 0; y < (2 * Matrix::MULTIPLEX * Matrix::CHAINS); y++) {
                 if ((x % (2 * Matrix::MULTIPLEX)) == y) {
                     buffers[buffer].data[y][x].red = 0;
                     buffers[buffer].data[y][x].green = 0;
@@ -30,14 +30,19 @@ namespace Serial::Node::Data {
             }
         }
         
-        buffer = (buffer + 1) % num_packets;   
-        Matrix::Worker::process(&buffers[(buffer + 1) % num_packets]);
+        // Buffer is owned by the worker once accepted, a rejected buffer is filled again.
+        if (Matrix::Worker::process(&buffers[buffer]))
+            buffer = (buffer + 1) % num_packets;
     }
 
     void __not_in_flash_func(callback)(Serial::packet **buf) {
         // Do nothing
     }
 
+    void __not_in_flash_func(commit)(Serial::packet *buf) {
+        // Do nothing
+    }
+
     uint16_t __not_in_flash_func(get_len)() {
         return sizeof(Serial::packet);
     }
@@ -9,18 +9,25 @@
 #include "Matrix/matrix.h"
 
 namespace APP {
-    static void __not_in_flash_func(dma_isr1)() {
+    static void __not_in_flash_func(dma_isr0)() {
         Matrix::dma_isr();
     }
 
+    static void __not_in_flash_func(pio_isr0)() {
+        Matrix::pio_isr();
+    }
+
     static void __not_in_flash_func(timer_isr)() {
         Matrix::timer_isr();
     }
 
     void isr_start_core1() {
-        irq_set_exclusive_handler(DMA_IRQ_1, dma_isr1);
-        irq_set_priority(DMA_IRQ_1, 0);
-        irq_set_enabled(DMA_IRQ_1, true);
+        irq_set_exclusive_handler(DMA_IRQ_0, dma_isr0);
+        irq_set_priority(DMA_IRQ_0, 0);
+        irq_set_enabled(DMA_IRQ_0, true);
+        irq_set_exclusive_handler(PIO0_IRQ_0, pio_isr0);
+        irq_set_priority(PIO0_IRQ_0, 0);
+        irq_set_enabled(PIO0_IRQ_0, true);
         irq_set_exclusive_handler(TIMER_IRQ_0 + Matrix::timer, timer_isr);
         irq_set_priority(TIMER_IRQ_0 + Matrix::timer, 0);
         irq_set_enabled(TIMER_IRQ_0 + Matrix::timer, true);
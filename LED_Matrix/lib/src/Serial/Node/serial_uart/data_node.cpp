@@ -38,13 +38,22 @@ namespace Serial::Node::Data {
         }
     }
     
+    // Packet buffers are handed out in rotation
+    //  Callback hands out the same buffer until the worker accepts it. (See commit)
+    //      Buffer of a rejected frame or of a command which is not a frame is filled again.
+    //      Worker owns fewer than num_packets accepted buffers, so the rotation never reaches one it still owns.
+    static Serial::packet buffers[num_packets];
+    static volatile uint8_t buffer = 0;
+
     void __not_in_flash_func(callback)(Serial::packet **buf) {
-        static Serial::packet buffers[num_packets];
-        static volatile uint8_t buffer = 0;
+        *buf = &buffers[buffer];
+    }
 
-        *buf = &buffers[(buffer + 1) % num_packets];
-        buffer = (buffer + 1) % num_packets;
-    }    
+    // Buffer was accepted by the worker (See Matrix::Worker::process)
+    void __not_in_flash_func(commit)(Serial::packet *buf) {
+        if (buf == &buffers[buffer])
+            buffer = (buffer + 1) % num_packets;
+    }
 
     uint16_t __not_in_flash_func(get_len)() {
         return sizeof(Serial::packet);
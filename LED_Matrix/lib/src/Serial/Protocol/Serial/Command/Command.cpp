@@ -58,10 +58,10 @@ namespace Serial::Protocol::DATA_NODE {
 
                     // This is protected by the reset timer, but mistakes can lead to high error rates
                     switch (state) {
-                        case 0: // Grab the header
-                            get_data(data.b, 12, true);
+                        case 0: // Grab the header (16 bytes, COLUMNS is 16-bit)
+                            get_data(data.b, 16, true);
 
-                            if (index == 12) {
+                            if (index == 16) {
                                 index = 0;
                                 state = 1;                      // Advances state (local)
                             }
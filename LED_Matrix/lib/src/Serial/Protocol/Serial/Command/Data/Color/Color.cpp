@@ -0,0 +1,54 @@
+/* 
+ * File:   Color.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include "pico/platform.h"
+#include "Serial/Protocol/Serial/Command/Data/Color/Color.h"
+#include "Matrix/matrix.h"
+#include "System/machine.h"
+
+namespace Serial::Protocol::DATA_NODE {
+    uint16_t Color::table[size ? size : 1];
+
+    void __not_in_flash_func(Color::process_command_internal)() {
+        state_data = DATA_STATES::PAYLOAD;
+        time = time_us_64();
+        status = Serial::Protocol::internal::STATUS::ACTIVE_0;
+        index = 0;
+    }
+
+    // Tables are not placed in the packet buffer, it may be smaller than the tables.
+    void __not_in_flash_func(Color::process_payload_internal)() {
+        get_data((uint8_t *) table, 2 * size, true);
+
+        if (index == (2 * size)) {
+            state_data = DATA_STATES::CHECKSUM_DELIMITER_PROCESS;
+            time = time_us_64();
+            index = 0;
+            status = Serial::Protocol::internal::STATUS::ACTIVE_1;
+        }
+    }
+
+    void __not_in_flash_func(Color::process_frame_internal)() {
+        // Future: Look into parity
+        if (ntohl(data.l[0]) == ~checksum) {
+            for (uint16_t i = 0; i < size; i++)
+                table[i] = ntohs(table[i]);
+
+            // Worker copies the tables, we do not need to wait for ready.
+            //  Refused if the worker has not taken the previous tables yet. (Host retries after the reset)
+            if (Matrix::Worker::set_color(table)) {
+                idle_num = (idle_num + 1) % 2;
+                state_data = DATA_STATES::SETUP;
+            }
+            else
+                error();
+        }
+    }
+
+    void __not_in_flash_func(Color::process_internal)(Serial::packet *buf, uint16_t len) {
+        // Do nothing
+    }
+}
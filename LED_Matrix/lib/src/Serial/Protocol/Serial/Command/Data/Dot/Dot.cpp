@@ -0,0 +1,55 @@
+/* 
+ * File:   Dot.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include "pico/platform.h"
+#include "Serial/Protocol/Serial/Command/Data/Dot/Dot.h"
+#include "Matrix/matrix.h"
+#include "System/machine.h"
+
+namespace Serial::Protocol::DATA_NODE {
+    uint8_t Dot::page[size];
+    uint16_t Dot::num;
+
+    // Page number is taken from the header before the checksum reuses it.
+    //  Big endian in the reserved bytes 14 and 15, bytes 8 to 13 keep the values of a frame. (See filter.cpp)
+    void __not_in_flash_func(Dot::process_command_internal)() {
+        num = ntohs(data.s[7]);
+        state_data = DATA_STATES::PAYLOAD;
+        time = time_us_64();
+        status = Serial::Protocol::internal::STATUS::ACTIVE_0;
+        index = 0;
+    }
+
+    // Page is not placed in the packet buffer, the worker may still be reading it.
+    void __not_in_flash_func(Dot::process_payload_internal)() {
+        get_data(page, size, true);
+
+        if (index == size) {
+            state_data = DATA_STATES::CHECKSUM_DELIMITER_PROCESS;
+            time = time_us_64();
+            index = 0;
+            status = Serial::Protocol::internal::STATUS::ACTIVE_1;
+        }
+    }
+
+    void __not_in_flash_func(Dot::process_frame_internal)() {
+        // Future: Look into parity
+        if (ntohl(data.l[0]) == ~checksum) {
+            // Blocks for the flash write, the first page of a sector also erases it. (Host waits for the status)
+            //  Refused if the page is past the end of the table.
+            if (Matrix::Worker::set_dot(num, page)) {
+                idle_num = (idle_num + 1) % 2;
+                state_data = DATA_STATES::SETUP;
+            }
+            else
+                error();
+        }
+    }
+
+    void __not_in_flash_func(Dot::process_internal)(Serial::packet *buf, uint16_t len) {
+        // Do nothing
+    }
+}
@@ -0,0 +1,51 @@
+/* 
+ * File:   Profile.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include "pico/platform.h"
+#include "Serial/Protocol/Serial/Command/Data/Profile/Profile.h"
+#include "Matrix/matrix.h"
+#include "System/machine.h"
+
+namespace Serial::Protocol::DATA_NODE {
+    uint8_t Profile::profile;
+
+    void __not_in_flash_func(Profile::process_command_internal)() {
+        state_data = DATA_STATES::PAYLOAD;
+        time = time_us_64();
+        status = Serial::Protocol::internal::STATUS::ACTIVE_0;
+        index = 0;
+    }
+
+    // Profile is not placed in data, the checksum reuses it.
+    void __not_in_flash_func(Profile::process_payload_internal)() {
+        get_data(&profile, 1, true);
+
+        if (index == 1) {
+            state_data = DATA_STATES::CHECKSUM_DELIMITER_PROCESS;
+            time = time_us_64();
+            index = 0;
+            status = Serial::Protocol::internal::STATUS::ACTIVE_1;
+        }
+    }
+
+    void __not_in_flash_func(Profile::process_frame_internal)() {
+        // Future: Look into parity
+        if (ntohl(data.l[0]) == ~checksum) {
+            // Display takes the profile with the next refresh, we do not need to wait for ready.
+            //  Refused if the profile does not exist.
+            if (Matrix::set_profile(profile)) {
+                idle_num = (idle_num + 1) % 2;
+                state_data = DATA_STATES::SETUP;
+            }
+            else
+                error();
+        }
+    }
+
+    void __not_in_flash_func(Profile::process_internal)(Serial::packet *buf, uint16_t len) {
+        // Do nothing
+    }
+}
@@ -5,9 +5,12 @@
  */
 
 #include "Serial/Protocol/Serial/filter.h"
+#include "Serial/Protocol/Serial/Command/Data/Color/Color.h"
 #include "Serial/Protocol/Serial/Command/Data/Data/Data.h"
+#include "Serial/Protocol/Serial/Command/Data/Dot/Dot.h"
 #include "Serial/Protocol/Serial/Command/Data/Raw_Data/Raw_Data.h"
 #include "Serial/Protocol/Serial/Command/Data/ID/ID.h"
+#include "Serial/Protocol/Serial/Command/Data/Profile/Profile.h"
 #include "Serial/Protocol/Serial/Command/Query/Test/Test.h"
 #include "Serial/Node/data.h"
 #include "System/machine.h"
@@ -21,24 +24,30 @@ namespace Serial::Protocol::DATA_NODE {
         static Raw_Data raw;
         static Test test;
         static ID id;
+        static Color color;
+        static Dot dot;
+        static Profile profile;
 
         SIMD::SIMD_SINGLE<uint32_t> key;
         SIMD::SIMD_SINGLE<uint32_t> enable;
 
-        // TCAM can covert 6-12 operations down to 3.
+        // TCAM can covert 6-12 operations down to 4.
         //  The conditionals can be removed with AND down to 1.
         enable.l[0] = 0xFFFFFFFF;
         enable.l[1] = 0xFFFFFFFF;
         enable.l[2] = 0xFFFFFFFF;
+        enable.l[3] = 0xFFFFFFFF;
 
         key.l[0] = htonl(0xAAEEAAEE);
         key.b[4] = 'd';
         key.b[5] = 'd';
         key.s[3] = htons(Serial::Node::Data::get_len());
         key.b[8] = sizeof(DEFINE_SERIAL_RGB_TYPE);
-        key.b[9] = Matrix::MULTIPLEX;
-        key.b[10] = Matrix::COLUMNS;
-        key.b[11] = DEFINE_SERIAL_RGB_TYPE::id;
+        key.b[9] = Matrix::MULTIPLEX * Matrix::CHAINS;     // Chains look like a taller panel to the host
+        key.s[5] = htons(Matrix::COLUMNS);
+        key.b[12] = DEFINE_SERIAL_RGB_TYPE::id;
+        key.b[13] = 0;                                      // Reserved
+        key.s[7] = 0;                                       // Reserved
         while (!data_filter.TCAM_rule(0, key, enable, &data));
 
         key.b[4] = 'r';
@@ -46,6 +55,7 @@ namespace Serial::Protocol::DATA_NODE {
 
 
         enable.l[2] = 0;
+        enable.l[3] = 0;
         key.s[3] = 1;
         key.b[5] = 'c';
         key.b[4] = 'i';
@@ -57,5 +67,30 @@ namespace Serial::Protocol::DATA_NODE {
         key.b[5] = 'q';
         key.b[4] = 't';
         while (!data_filter.TCAM_rule(3, key, enable, &test));
+
+
+        // RGB48 has no color tables
+        if (Color::size != 0) {
+            enable.s[3] = 0xFFFF;
+            key.s[3] = htons(2 * Color::size);
+            key.b[5] = 'c';
+            key.b[4] = 'l';
+            while (!data_filter.TCAM_rule(4, key, enable, &color));
+        }
+
+
+        // Page number is big endian in the reserved bytes 14 and 15 (See Dot.cpp)
+        enable.s[3] = 0xFFFF;
+        key.s[3] = htons(Dot::size);
+        key.b[5] = 'c';
+        key.b[4] = 'k';
+        while (!data_filter.TCAM_rule(5, key, enable, &dot));
+
+
+        enable.s[3] = 0xFFFF;
+        key.s[3] = htons(1);
+        key.b[5] = 'c';
+        key.b[4] = 'p';
+        while (!data_filter.TCAM_rule(6, key, enable, &profile));
     }
 }
\ No newline at end of file
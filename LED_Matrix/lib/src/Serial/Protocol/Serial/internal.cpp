@@ -22,7 +22,9 @@ namespace Serial::Protocol::internal {
                 break;
         }
 
-        Matrix::Worker::process(p);
+        // Data node fills the same buffer again if the frame was rejected
+        if (Matrix::Worker::process(p))
+            Serial::Node::Data::commit(p);
     }
 
     void __not_in_flash_func(send_status)(STATUS status) {
@@ -0,0 +1,55 @@
+# Configuration options (Shared with the host tests, see test/CMakeLists.txt)
+#   These determine the generated headers (config.h and memory_format.h) of every module.
+
+# This determines application name
+set(DEFINE_APP "app" CACHE STRING "Binary name")
+
+# These determine code modules (linker)
+set(DEFINE_SERIAL_NODE "uart" CACHE STRING "Serial node algorithm name")
+set(DEFINE_SERIAL_PROTOCOL "serial" CACHE STRING "Serial protocol algorithm name")
+set(DEFINE_MULTIPLEX_ALGORITHM "Decoder" CACHE STRING "Multiplex algorithm name")
+set(DEFINE_MULTIPLEX_FOLDER "HUB75" CACHE STRING "Multiplex interface family")
+set(DEFINE_MATRIX_ALGORITHM "PWM" CACHE STRING "Matrix algorithm name")
+set(DEFINE_MATRIX_FOLDER "HUB75" CACHE STRING "Matrix interface family")
+
+# This determines the shifter type (0 is reserved!)
+set(DEFINE_MULTIPLEX_TYPE "1" CACHE STRING "Shifter Multiplex Type")
+set(DEFINE_MULTIPLEX_CLOCK "5.0" CACHE STRING "Shifter Multiplex clock speed in MHz")
+
+# These determine RAM usage
+set(DEFINE_SERIAL_RGB_TYPE "RGB24" CACHE STRING "RGB type name")
+set(DEFINE_MULTIPLEX_SCAN "8" CACHE STRING "Panel scan")
+set(DEFINE_COLUMNS "32" CACHE STRING "Shift chain length")
+set(DEFINE_MATRIX_CHAINS "1" CACHE STRING "Number of shift chains driven in parallel (1, 2 or 3)")
+set(DEFINE_MAX_RGB_LED_STEPS "130" CACHE STRING "Min constrast of LED without multiplexing")
+set(DEFINE_MATRIX_ROW_DMA "false" CACHE STRING "Shift every row with one DMA transfer instead of a DMA control block per line (PWM only)")
+
+# These determine timing and state machine settings at compile time
+set(DEFINE_MATRIX_DCLOCK "17.0" CACHE STRING "Matrix serial clock speed in MHz")
+set(DEFINE_MATRIX_GCLOCK "17.0" CACHE STRING "Matrix grayscale clock speed in MHz (GCLK only)")
+set(DEFINE_SERIAL_UART_BAUD "4000000" CACHE STRING "Serial algorithm baud rate in Baud")
+set(DEFINE_BLANK_TIME "10" CACHE STRING "Blank time in microseconds")
+set(DEFINE_MATRIX_DMA_SCAN "false" CACHE STRING "Sequence OE, row address and blank time with DMA instead of interrupts (PWM requires DEFINE_MATRIX_ROW_DMA, not with ENGINE)")
+set(DEFINE_MATRIX_PWM_GAMMA "1.0" CACHE STRING "Gamma of the PWM line durations, 1.0 is linear (PWM with DEFINE_MATRIX_ROW_DMA only)")
+set(DEFINE_MATRIX_SUB_PERIODS "4" CACHE STRING "Number of sub periods per PWM period (SPWM only)")
+set(DEFINE_MATRIX_PWM_LOW_BITS "3" CACHE STRING "Number of low bits shown as PWM, the rest are BCM (HYBRID only)")
+set(DEFINE_MATRIX_PROFILES "1" CACHE STRING "Number of depth profiles selectable at runtime, profile p drops p bitplanes (BCM and ENGINE only)")
+
+# These determine the color tables of the worker (Uploads replace them at runtime)
+set(DEFINE_COLOR_GAMMA "1.0" CACHE STRING "Gamma of the color tables, 1.0 is linear (RGB48 is always linear)")
+set(DEFINE_COLOR_RED "1.0" CACHE STRING "White balance of red, scales the red color table")
+set(DEFINE_COLOR_GREEN "1.0" CACHE STRING "White balance of green, scales the green color table")
+set(DEFINE_COLOR_BLUE "1.0" CACHE STRING "White balance of blue, scales the blue color table")
+set(DEFINE_COLOR_DITHER "0" CACHE STRING "Number of fraction bits kept below the PWM bits and shown with ordered dithering (0 to 4)")
+
+# These determine the pixel mapping of the worker (Host sends the logical image)
+set(DEFINE_PIXEL_LAYOUT "0" CACHE STRING "Panel layout (0 is linear, 1 is stripe and 2 is zig-zag)")
+set(DEFINE_PIXEL_FOLD "1" CACHE STRING "Number of panel rows driven by every scan row of a half (Stripe and zig-zag only)")
+set(DEFINE_PIXEL_BLOCK "8" CACHE STRING "Number of columns shifted into a panel row before the next panel row (Stripe and zig-zag only)")
+set(DEFINE_PIXEL_ROTATION "0" CACHE STRING "Clockwise rotation of the logical image in degrees (0, 90, 180 or 270)")
+set(DEFINE_PIXEL_MIRROR "0" CACHE STRING "Mirror the panel before rotation (0 is none, 1 is horizontal, 2 is vertical and 3 is both)")
+
+# These verify the configuration settings at compile time
+set(DEFINE_FPS "30" CACHE STRING "Frames per second")
+set(DEFINE_MIN_REFRESH "3000" CACHE STRING "Refresh rate")
+set(DEFINE_BYPASS_FANOUT "false" CACHE STRING "Disable verification of max Matrix algorithm Serial clock fanout speed limit")
@@ -14,21 +14,22 @@
 
 static void __not_in_flash_func(loop_core0)() {
     while (1) {
-        // Uses blocking pushes to FIFO.
+        // Matrix::Worker::process does not block. (Descriptor ring, FIFO is only a doorbell.)
         Serial::Node::Control::task();
         Serial::Node::Data::task();
         Serial::Protocol::task();
+        Matrix::Worker::assist();   // Takes a row of the current packet, if any. (Bounded polling latency.)
 
         watchdog_update();          // We are only interested in protecting core 0
     }
 }
 
 static void __not_in_flash_func(loop_core1)() {
-    Matrix::start();                // Note ISR logic should be detected by watchdog. (FIFO will fill up and Matrix::Worker::work will stall.)
-    APP::isr_start_core1();         // Matrix ISRs are allocated to this core. (These will slow the FIFO consumption rate.)
+    Matrix::start();                // Note a stalled core 1 is no longer seen by the watchdog. (Queue fills up and frames are rejected, see Matrix::Worker::get_statistics.)
+    APP::isr_start_core1();         // Matrix ISRs are allocated to this core. (These will slow the queue consumption rate.)
 
     while (1) {
-        Matrix::Worker::work();     // Note is capable of stalling the watchdog via FIFO consumption rate. (Reduce OPs if need be.)
+        Matrix::Worker::work();     // Note slow consumption drops frames rather than stalling core 0. (Reduce OPs if need be.)
     }
 }
 
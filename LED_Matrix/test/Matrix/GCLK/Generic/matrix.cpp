@@ -0,0 +1,223 @@
+/* 
+ * File:   matrix.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "test.h"
+#include "model.h"
+
+// Worker is built into the test, matrix.cpp, Buffer.cpp and calculator.cpp are built as they are. The hardware is the model. (See model.cpp)
+#include "lib/src/Matrix/GCLK/Generic/worker.cpp"
+#include "Matrix/GCLK/hw_config.h"
+#include "Multiplex/HUB75/hw_config.h"
+
+using namespace Matrix;
+using namespace Matrix::BCM;
+
+// Waveform test of the GCLK Generic algorithm
+//  A driver model decodes the commands from the DCLK rising edges with LE high and keeps the grayscale of every channel.
+//  Rows end with the PIO interrupt, every row must get GCLK_PER_ROW GCLKs with its address on the pins.
+
+constexpr uint32_t dma_chan = 0;                    // Only channel claimed by matrix.cpp
+
+// -- Driver model --
+
+constexpr uint32_t dclk_pin = GCLK::GCLK_DCLK;
+constexpr uint32_t le_pin = GCLK::GCLK_DCLK + 1;
+constexpr uint32_t gclk_pin = GCLK::GCLK_GCLK;
+
+static uint32_t last = 0;                           // Pins of the previous call
+static uint32_t pio_interrupts = 0;                 // End of row interrupts seen
+static std::vector<uint8_t> shifted[6 * CHAINS];   // Data bits of every pin in shift order
+static uint32_t le_count = 0;
+static uint32_t latch_index = 0;                    // Channel pointer of the drivers, row * 16 + channel
+static std::vector<uint16_t> write_ram(MULTIPLEX * 16 * 6 * CHAINS * drivers, 0xFFFF);
+static std::vector<uint16_t> display_ram(MULTIPLEX * 16 * 6 * CHAINS * drivers, 0xFFFF);
+static uint32_t latches = 0;
+static uint32_t vsyncs = 0;
+static uint32_t vsync_rows[2];
+static uint32_t unknown_commands = 0;
+static uint32_t vsync_during_gclk = 0;
+
+// Rows and GCLKs of the display
+static uint32_t rows = 0;
+static uint32_t gclk_pulses = 0;
+static uint32_t bad_gclk_rows = 0;
+static uint32_t bad_address = 0;
+
+// Wrap bottom of the GCLK state machine is its wait for the row (See matrix.cpp)
+static uint32_t get_gclk_wait() {
+    return (pio0_hw->sm[1].execctrl >> PIO_SM0_EXECCTRL_WRAP_BOTTOM_LSB) & 31;
+}
+
+static uint32_t get_index(uint32_t row, uint32_t channel, uint32_t pin, uint32_t driver) {
+    return (((((row * 16) + channel) * 6 * CHAINS) + pin) * drivers) + driver;
+}
+
+// Word of every driver for every pin, driver 0 is shifted first and MSB first.
+static uint16_t get_word(uint32_t pin, uint32_t driver) {
+    uint16_t v = 0;
+
+    for (uint32_t b = 0; b < 16; b++)
+        v = (v << 1) | shifted[pin][(driver * 16) + b];
+
+    return v;
+}
+
+static void command() {
+    if (le_count == GCLK::GCLK_LE_DATA_LATCH) {
+        CHECK(shifted[0].size() == (drivers * 16u));
+
+        if ((shifted[0].size() == (drivers * 16u)) && (latch_index < (MULTIPLEX * 16u))) {
+            for (uint32_t p = 0; p < (6 * CHAINS); p++)
+                for (uint32_t d = 0; d < drivers; d++)
+                    write_ram[get_index(latch_index / 16, latch_index % 16, p, d)] = get_word(p, d);
+        }
+
+        latch_index++;
+        latches++;
+    }
+    else if (le_count == GCLK::GCLK_LE_VSYNC) {
+        CHECK((latch_index == 0) || (latch_index == (MULTIPLEX * 16u)));        // Never part of a frame
+
+        if (Model::get_pc(1) != get_gclk_wait())                                // GCLK must be waiting for the row
+            vsync_during_gclk++;
+
+        if (vsyncs < 2)
+            vsync_rows[vsyncs] = rows;
+
+        display_ram = write_ram;
+        latch_index = 0;
+        vsyncs++;
+    }
+    else
+        unknown_commands++;
+
+    for (auto &s : shifted)
+        s.clear();
+
+    le_count = 0;
+}
+
+static void watch(uint32_t pins) {
+    const uint32_t rising = pins & ~last;
+
+    // End of row (PIO interrupt)
+    if (Model::interrupts.pio != pio_interrupts) {
+        if (gclk_pulses != GCLK::GCLK_PER_ROW)
+            bad_gclk_rows++;
+
+        pio_interrupts = Model::interrupts.pio;
+        gclk_pulses = 0;
+        rows++;
+    }
+
+    if ((rising >> gclk_pin) & 1) {
+        gclk_pulses++;
+
+        if (((pins >> Multiplex::HUB75::HUB75_ADDR_BASE) & 31) != (rows % MULTIPLEX))
+            bad_address++;
+    }
+
+    if ((rising >> dclk_pin) & 1) {
+        for (uint32_t p = 0; p < (6 * CHAINS); p++)
+            shifted[p].push_back((pins >> (GCLK::GCLK_DATA_BASE + p)) & 1);
+
+        if ((pins >> le_pin) & 1)
+            le_count++;
+    }
+
+    if ((((pins >> le_pin) & 1) == 0) && (le_count != 0))
+        command();
+
+    last = pins;
+}
+
+// Runs until the condition holds, one grayscale period at most.
+template <typename F> static bool run_until(F f) {
+    const uint64_t limit = 4 * MULTIPLEX * sub_periods * ((GCLK::GCLK_PER_ROW * 125000000.0 / GRAYSCALE_CLOCK) + ((BLANK_TIME + 1) * 125.0));
+    return Model::run_until(f, limit);
+}
+
+// Grayscale word of a channel, zero padding before PWM_bits of the value
+static uint16_t get_expected(Serial::packet *p, uint32_t row, uint32_t channel, uint32_t pin, uint32_t driver) {
+    const uint32_t chain = pin / 6;
+    const uint32_t k = pin % 6;
+    const uint32_t r = row + ((k >= 3) ? MULTIPLEX : 0) + (chain * 2 * MULTIPLEX);
+    const uint32_t m = APP::Map::get(r, (driver * 16) + channel);
+    const Serial::pixel *s = APP::Map::pixel(p, m);
+    const uint16_t in[3] = { s->red, s->green, s->blue };
+
+    return APP::Dot::apply(BCM::Worker::color.get(k % 3, in[k % 3]), APP::Dot::get(m)[k % 3]);
+}
+
+static bool is_displayed(Serial::packet *p) {
+    bool ok = true;
+
+    for (uint32_t r = 0; r < MULTIPLEX; r++)
+        for (uint32_t c = 0; c < 16; c++)
+            for (uint32_t pin = 0; pin < (6 * CHAINS); pin++)
+                for (uint32_t d = 0; d < drivers; d++)
+                    ok &= display_ram[get_index(r, c, pin, d)] == (p ? get_expected(p, r, c, pin, d) : 0);
+
+    return ok;
+}
+
+int main() {
+    static BCM::Worker::BCM_worker<uint8_t> w;
+    static Serial::packet p;
+
+    BCM::Worker::row_lock = spin_lock_init(spin_lock_claim_unused(true));
+    Model::watch = watch;
+
+    // Start shifts the blank bank without VSYNC
+    Matrix::start();
+    Model::sync();
+    CHECK((Model::get_dma_triggers(dma_chan) == 1) && (Model::get_dma_count(dma_chan) == ((frame_length - vsync_length) / 4)));
+    CHECK(run_until([]() { return !dma_channel_is_busy(dma_chan) && (Model::get_tx_level(0) == 0) && (Model::get_pc(0) == 0); }));
+    CHECK(latches == (MULTIPLEX * 16u));
+    CHECK(vsyncs == 0);
+
+    srand(1);
+
+    for (uint32_t r = 0; r < (2 * MULTIPLEX * CHAINS); r++)
+        for (uint16_t x = 0; x < COLUMNS; x++) {
+            Serial::pixel *s = (Serial::pixel *) APP::Map::pixel(&p, APP::Map::get(r, x));
+            s->red = rand();
+            s->green = rand();
+            s->blue = rand();
+        }
+
+    w.process_packet(&p);
+
+    // End of the first grayscale period: VSYNC shows the blank bank, the new bank follows in the same stream.
+    CHECK(run_until([]() { return vsyncs == 1; }));
+    CHECK((Model::get_dma_triggers(dma_chan) == 2) && (Model::get_dma_count(dma_chan) == (frame_length / 4)));
+    CHECK(is_displayed(nullptr));
+
+    // End of the next grayscale period: VSYNC alone shows the new bank.
+    CHECK(run_until([]() { return vsyncs == 2; }));
+    CHECK((Model::get_dma_triggers(dma_chan) == 3) && (Model::get_dma_count(dma_chan) == (vsync_length / 4)));
+    CHECK(is_displayed(&p));
+    CHECK((vsync_rows[1] - vsync_rows[0]) == (MULTIPLEX * sub_periods));
+
+    // Nothing new, the drivers keep the displayed frame.
+    const uint32_t r = rows;
+    CHECK(!run_until([]() { return vsyncs == 3; }));
+    CHECK(Model::get_dma_triggers(dma_chan) == 3);
+    CHECK(rows > (r + (2 * MULTIPLEX * sub_periods)));
+
+    CHECK(unknown_commands == 0);
+    CHECK(vsync_during_gclk == 0);
+    CHECK(bad_gclk_rows == 0);
+    CHECK(bad_address == 0);
+    CHECK(Model::errors == 0);
+    printf("%u rows, %u GCLKs per row, %u sub periods, %u latches\n", rows, GCLK::GCLK_PER_ROW, sub_periods, latches);
+    return Test::result();
+}
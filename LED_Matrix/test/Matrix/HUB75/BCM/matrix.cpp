@@ -0,0 +1,178 @@
+/* 
+ * File:   matrix.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include "test.h"
+#include "model.h"
+
+// Engine, worker, matrix.cpp and calculator.cpp are built into the test, the hardware is the model. (See model.cpp)
+#include "lib/src/Matrix/HUB75/BCM/Buffer.cpp"
+#include "lib/src/Matrix/HUB75/BCM/worker.cpp"
+#include "lib/src/Matrix/HUB75/BCM/matrix.cpp"
+#include "lib/src/Matrix/HUB75/BCM/calculator.cpp"
+#include "lib/src/Matrix/HUB75/BCM/engine.cpp"
+#include "Matrix/HUB75/panel.h"
+
+using namespace Matrix;
+using namespace Matrix::BCM;
+
+// Waveform test of the BCM algorithm
+//  Rows are sequenced by interrupts, or by the DMA control blocks with DMA_SCAN. (See matrix.cpp)
+//  The panel model counts the on time of every LED over one refresh, bitplane i is on for lsb_cycles * 2^i.
+
+// Nibble type of the LUT path (See work)
+using nibble_t = std::conditional_t<(PWM_bits % 4) == 0, uint32_t, std::conditional_t<(PWM_bits % 4) == 2, uint16_t, uint8_t>>;
+
+static const char *get_path() {
+    return (DMA_SCAN && scan) ? "DMA scan" : "interrupts";
+}
+
+// System clock cycles of a PIO cycle
+static double get_divider() {
+    const uint32_t clkdiv = pio0_hw->sm[0].clkdiv;
+    return (clkdiv >> PIO_SM0_CLKDIV_INT_LSB) + (((clkdiv >> PIO_SM0_CLKDIV_FRAC_LSB) & 0xFF) / 256.0);
+}
+
+// Runs until row 0 is lit again
+static bool run_refresh() {
+    const uint32_t r = Panel::refreshes;
+    const uint64_t limit = Model::cycles + (4 * 125000000ull / MIN_REFRESH);
+
+    while ((Panel::refreshes == r) && (Model::cycles < limit))
+        Model::run(1);
+
+    return Panel::refreshes != r;
+}
+
+// Every LED is on for the weights of the bits of its value, within a few PIO cycles. (Black without a packet)
+static void check_refresh(Serial::packet *p) {
+    static const Serial::pixel black = {};
+    const double divider = get_divider();
+    double error = 0;
+
+    Panel::clear();
+    CHECK(run_refresh());
+    Panel::flush();
+
+    for (uint8_t y = 0; y < MULTIPLEX; y++) {
+        for (uint8_t chain = 0; chain < CHAINS; chain++) {
+            for (uint16_t x = 0; x < COLUMNS; x++) {
+                for (uint8_t half = 0; half < 2; half++) {
+                    const uint16_t r = y + (((chain * 2) + half) * MULTIPLEX);
+                    const uint32_t m = APP::Map::get(r, x);
+                    const Serial::pixel *s = p ? APP::Map::pixel(p, m) : &black;
+                    const uint16_t in[3] = { s->red, s->green, s->blue };
+
+                    for (uint8_t c = 0; c < 3; c++) {
+                        const uint16_t v = APP::Dither<PWM_bits>::apply(APP::Dot::apply(BCM::Worker::color.get(c, in[c]), APP::Dot::get(m)[c]), APP::Dither<PWM_bits>::get(r, x));
+                        const double expected = (double) lsb_cycles * (v & ((1 << PWM_bits) - 1)) * divider;
+                        const double on = Panel::on[y][(chain * 6) + (half * 3) + c][x];
+
+                        error = std::max(error, std::abs(on - expected) / divider);
+                    }
+                }
+            }
+        }
+    }
+
+    CHECK(error <= 4);
+}
+
+static void fill(Serial::packet *p, uint32_t seed) {
+    srand(seed);
+
+    for (uint32_t r = 0; r < (2 * MULTIPLEX * CHAINS); r++)
+        for (uint16_t x = 0; x < COLUMNS; x++) {
+            Serial::pixel *s = (Serial::pixel *) APP::Map::pixel(p, APP::Map::get(r, x));
+            s->red = rand();
+            s->green = rand();
+            s->blue = rand();
+        }
+}
+
+int main() {
+    static BCM::Worker::BCM_worker<nibble_t> w;
+    static Serial::packet p[2];
+    constexpr uint32_t refreshes = 20;
+
+    BCM::Worker::row_lock = spin_lock_init(spin_lock_claim_unused(true));
+    Model::watch = Panel::watch;
+    Matrix::start();
+    Model::sync();
+
+    // Blank bank until a frame arrives
+    CHECK(run_refresh());
+    check_refresh(nullptr);
+
+    // Bank is swapped at the start of a refresh
+    for (uint32_t i = 0; i < 2; i++) {
+        fill(&p[i], i + 1);
+        w.process_packet(&p[i]);
+        CHECK(run_refresh());
+        check_refresh(&p[i]);
+    }
+
+    // Interrupts per refresh
+    //  Interrupt path: End of row and blank timer for every row. DMA_SCAN: Bank swap once per refresh.
+    const Model::interrupts_t before = Model::interrupts;
+    const uint64_t cycles = Model::cycles;
+    const uint64_t ns = Model::isr_ns;
+
+    for (uint32_t i = 0; i < refreshes; i++)
+        CHECK(run_refresh());
+
+    const uint32_t pio = Model::interrupts.pio - before.pio;
+    const uint32_t dma = Model::interrupts.dma - before.dma;
+    const uint32_t timer = Model::interrupts.timer - before.timer;
+    const double refresh = (125000000.0 * refreshes) / (Model::cycles - cycles);
+    const double per_refresh = (double) (pio + dma + timer) / refreshes;
+
+    if (DMA_SCAN && scan)
+        CHECK((pio == 0) && (timer == 0) && (dma == refreshes));
+    else
+        CHECK((pio == (refreshes * MULTIPLEX)) && (timer == pio) && (dma == 0));
+
+    // Sequence of every row: OE is off while the address changes and rows are in order.
+    CHECK(Panel::lit_changes == 0);
+    CHECK(Panel::bad_rows == 0);
+
+    // Same blank time as PWM, the first bitplane is shifted while OE is off. (See calculator.cpp)
+    //  Blank timer has one microsecond resolution, end of row and latch take a few PIO cycles.
+    const double period_us = 1000000.0 / (MULTIPLEX * MIN_REFRESH);
+    const double blank_us = period_us - (period_us / Calculator::get_refresh_overhead());
+    CHECK((Panel::min_blank_clocks == line_columns) && (Panel::max_blank_clocks == line_columns));
+    CHECK(Panel::min_blank >= (blank_us * 125));
+    CHECK(Panel::max_blank <= (((blank_us + 1) * 125) + (10 * get_divider())));
+
+    // Every bitplane is shifted once and pulsed once, bitplane i for lsb_cycles * 2^i PIO cycles. (Profile 0)
+    const double divider = get_divider();
+    double error = 0;
+
+    CHECK((Panel::min_row_clocks == (PWM_bits * line_columns)) && (Panel::max_row_clocks == (PWM_bits * line_columns)));
+    CHECK(Panel::max_row_pulses == PWM_bits);
+
+    for (uint8_t i = 0; i < PWM_bits; i++) {
+        const double expected = (lsb_cycles << i) * divider;
+        error = std::max(error, std::max(std::abs(Panel::min_pulse[i] - expected), std::abs(Panel::max_pulse[i] - expected)) / divider);
+    }
+
+    CHECK(error <= 1);
+    CHECK(Model::errors == 0);
+
+    // Core 1 takes every interrupt, the worker gets the cycles back. (At least the exception entry of the Cortex-M0+)
+    printf("%s: %.0f Hz refresh, %.2f interrupts per refresh, %.0f interrupts per second, %.0f ns host time per refresh in the ISRs\n",
+        get_path(), refresh, per_refresh, per_refresh * refresh, (double) (Model::isr_ns - ns) / refreshes);
+
+    if (DMA_SCAN && scan)
+        printf("%s: %.0f interrupts per second and at least %.0f worker cycles per second reclaimed from the interrupt path\n",
+            get_path(), ((2.0 * MULTIPLEX) - per_refresh) * refresh, ((2.0 * MULTIPLEX) - per_refresh) * refresh * 15);
+
+    return Test::result();
+}
@@ -0,0 +1,100 @@
+/* 
+ * File:   worker.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <type_traits>
+#include "test.h"
+
+// Worker and buffer are built into the test
+#include "lib/src/Matrix/HUB75/BCM/Buffer.cpp"
+#include "lib/src/Matrix/HUB75/BCM/worker.cpp"
+
+// Calculator is not built into the test, a configuration which does not fit would write past the banks. (See calculator.cpp)
+static_assert((Matrix::MULTIPLEX * Matrix::BCM::row_length) <= Serial::max_framebuffer_size, "Configuration of the test does not fit the buffer");
+
+using namespace Matrix;
+using namespace Matrix::BCM;
+using namespace Matrix::BCM::Worker;
+
+// Nibble type of the LUT path (See work)
+using nibble_t = std::conditional_t<(PWM_bits % 4) == 0, uint32_t, std::conditional_t<(PWM_bits % 4) == 2, uint16_t, uint8_t>>;
+
+// Bit sliced path (set_pixels) is taken for whole words of columns, otherwise the LUT path (set_pixel). (See set_row)
+//  Both are checked against the same bitplanes, so the two paths produce the same bank.
+constexpr const char *path = ((COLUMNS % 4) == 0) ? "bit sliced" : "LUT";
+
+// Bitplane i of a channel holds bit i of its value. (See Buffer.cpp)
+static void check_frame(Serial::packet *p) {
+    BCM::Buffer *b = &buf[bank_last];
+    bool ok = true;
+
+    for (uint8_t y = 0; y < MULTIPLEX; y++) {
+        for (uint8_t chain = 0; chain < CHAINS; chain++) {
+            for (uint16_t x = 0; x < COLUMNS; x++) {
+                for (uint8_t half = 0; half < 2; half++) {
+                    const uint16_t r = y + (((chain * 2) + half) * MULTIPLEX);
+                    const uint32_t m = APP::Map::get(r, x);
+                    const Serial::pixel *s = APP::Map::pixel(p, m);
+                    const uint16_t in[3] = { s->red, s->green, s->blue };
+
+                    for (uint8_t c = 0; c < 3; c++) {
+                        const uint16_t v = APP::Dither<PWM_bits>::apply(APP::Dot::apply(color.get(c, in[c]), APP::Dot::get(m)[c]), APP::Dither<PWM_bits>::get(r, x));
+
+                        for (uint16_t i = 0; i < PWM_bits; i++) {
+                            const line_t *element = (const line_t *) (b->get_line(y, i) + b->get_column_offset()) + x;
+                            ok &= ((*element >> ((6 * chain) + (half * 3) + c)) & 1) == ((v >> i) & 1);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    CHECK(ok);
+}
+
+static void fill(Serial::packet *p, uint32_t seed) {
+    srand(seed);
+
+    for (uint32_t r = 0; r < (2 * MULTIPLEX * CHAINS); r++)
+        for (uint16_t x = 0; x < COLUMNS; x++) {
+            Serial::pixel *s = (Serial::pixel *) APP::Map::pixel(p, APP::Map::get(r, x));
+            s->red = rand();
+            s->green = rand();
+            s->blue = rand();
+        }
+}
+
+int main() {
+    static BCM_worker<nibble_t> w;
+    static Serial::packet p[3];
+    constexpr uint32_t frames = 1000;
+    constexpr uint32_t pixels = 2 * MULTIPLEX * CHAINS * COLUMNS;
+
+    row_lock = spin_lock_init(spin_lock_claim_unused(true));
+
+    for (uint32_t i = 0; i < 10; i++) {
+        fill(&p[i % 3], i);
+        w.process_packet(&p[i % 3]);
+        check_frame(&p[i % 3]);
+    }
+
+    // Benchmark: Every row of every frame is converted (Includes the row hashes)
+    //  Nothing takes the banks, the worker alternates between two. Three frames keep every row dirty.
+    const uint32_t converted = stats.rows_converted;
+    const uint64_t start = Test::now_ns();
+
+    for (uint32_t i = 0; i < frames; i++)
+        w.process_packet(&p[(i + 1) % 3]);
+
+    const double ns = (double) (Test::now_ns() - start) / (frames * pixels);
+
+    CHECK((stats.rows_converted - converted) == (frames * MULTIPLEX));             // Nothing was skipped or copied
+    check_frame(&p[frames % 3]);
+    printf("PWM_bits %u, %u columns, %s: %.2f ns/pixel\n", PWM_bits, COLUMNS, path, ns);
+    return Test::result();
+}
@@ -0,0 +1,23 @@
+/* 
+ * File:   bcm.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include "Serial/config.h"
+#include "Matrix/engine.h"
+#include "Matrix/dot.h"
+#include "Matrix/dither.h"
+#include "Matrix/HUB75/BCM/memory_format.h"
+
+// Expected on time of BCM, built against the BCM memory format. (See matrix.cpp)
+namespace Matrix::BCM {
+    // Weights of the bits of the value in PIO cycles, profile 0 (See test/Matrix/HUB75/BCM/matrix.cpp)
+    double get_on(const Serial::pixel *s, uint32_t m, uint16_t r, uint16_t x, uint8_t c) {
+        const uint16_t in[3] = { s->red, s->green, s->blue };
+        const uint16_t v = APP::Dither<PWM_bits>::apply(APP::Dot::apply(Matrix::Worker::color<PWM_bits>.get(c, in[c]), APP::Dot::get(m)[c]), APP::Dither<PWM_bits>::get(r, x));
+
+        return (double) lsb_cycles * (v & ((1 << PWM_bits) - 1));
+    }
+}
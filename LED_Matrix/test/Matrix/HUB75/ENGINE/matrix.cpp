@@ -0,0 +1,168 @@
+/* 
+ * File:   matrix.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <cmath>
+#include "hardware/pio.h"
+#include "test.h"
+#include "model.h"
+
+// Engine is built into the test, PWM and BCM are built as they are with their own memory formats. The hardware is the model. (See model.cpp)
+//  Options shared by both memory formats are taken from the PWM format.
+#include "lib/src/Matrix/HUB75/ENGINE/engine.cpp"
+#include "Matrix/HUB75/PWM/memory_format.h"
+#include "Matrix/map.h"
+#include "Matrix/HUB75/panel.h"
+
+using namespace Matrix;
+
+// Waveform test of the engine of PWM and BCM (See Matrix/engine.h)
+//  Static content is switched from PWM to BCM and back by profile, the worker converts the frame again for the new algorithm.
+//  Every refresh across a switch is a refresh of either algorithm, rows stay in order and OE is off while they change.
+
+// Expected on time in PIO cycles (See pwm.cpp and bcm.cpp)
+namespace Matrix::PWM {
+    double get_on(const Serial::pixel *s, uint32_t m, uint16_t r, uint16_t x, uint8_t c);
+}
+
+namespace Matrix::BCM {
+    double get_on(const Serial::pixel *s, uint32_t m, uint16_t r, uint16_t x, uint8_t c);
+}
+
+// System clock cycles of a PIO cycle (Same serial clock for both)
+static double get_divider() {
+    const uint32_t clkdiv = pio0_hw->sm[0].clkdiv;
+    return (clkdiv >> PIO_SM0_CLKDIV_INT_LSB) + (((clkdiv >> PIO_SM0_CLKDIV_FRAC_LSB) & 0xFF) / 256.0);
+}
+
+// Runs until row 0 is lit again
+static bool run_refresh() {
+    const uint32_t r = Panel::refreshes;
+    const uint64_t limit = Model::cycles + (4 * 125000000ull / PWM::MIN_REFRESH);
+
+    while ((Panel::refreshes == r) && (Model::cycles < limit))
+        Model::run(1);
+
+    return Panel::refreshes != r;
+}
+
+// Every LED is on for the time of the displayed algorithm, within a few PIO cycles of it.
+static void check_refresh(Serial::packet *p, double (*get_on)(const Serial::pixel *, uint32_t, uint16_t, uint16_t, uint8_t)) {
+    const double divider = get_divider();
+    double error = 0;
+
+    Panel::clear();
+    CHECK(run_refresh());
+    Panel::flush();
+
+    for (uint8_t y = 0; y < MULTIPLEX; y++) {
+        for (uint8_t chain = 0; chain < CHAINS; chain++) {
+            for (uint16_t x = 0; x < COLUMNS; x++) {
+                for (uint8_t half = 0; half < 2; half++) {
+                    const uint16_t r = y + (((chain * 2) + half) * MULTIPLEX);
+                    const uint32_t m = APP::Map::get(r, x);
+                    const Serial::pixel *s = APP::Map::pixel(p, m);
+
+                    for (uint8_t c = 0; c < 3; c++) {
+                        const double expected = get_on(s, m, r, x, c) * divider;
+                        const double on = Panel::on[y][(chain * 6) + (half * 3) + c][x];
+
+                        error = std::max(error, std::abs(on - expected) / divider);
+                    }
+                }
+            }
+        }
+    }
+
+    CHECK(error <= 4);
+}
+
+static void fill(Serial::packet *p, uint32_t seed) {
+    srand(seed);
+
+    for (uint32_t r = 0; r < (2 * MULTIPLEX * CHAINS); r++)
+        for (uint16_t x = 0; x < COLUMNS; x++) {
+            Serial::pixel *s = (Serial::pixel *) APP::Map::pixel(p, APP::Map::get(r, x));
+            s->red = rand();
+            s->green = rand();
+            s->blue = rand();
+        }
+}
+
+// Longest refresh of the displayed algorithm
+static uint64_t get_refresh() {
+    Panel::clear();
+
+    for (uint32_t i = 0; i < 4; i++)
+        CHECK(run_refresh());
+
+    return Panel::max_refresh;
+}
+
+// Refresh across a switch, the displayed algorithm keeps refreshing until its frame boundary.
+//  Ends when the target lights row 0.
+static uint64_t run_switch(uint8_t profile) {
+    CHECK(Matrix::set_profile(profile));
+    engine::poll();                                                 // Worker converts the frame for the new algorithm and arms the switch
+    Panel::clear();
+    CHECK(run_refresh());
+    return Panel::max_refresh;
+}
+
+int main() {
+    static Serial::packet p[2];
+    constexpr double margin = 2 * 125;                              // Blank timer has one microsecond resolution
+
+    Model::watch = Panel::watch;
+    Matrix::start();
+    PWM::Worker::start();                                           // Worker loop is run by the test (See engine::poll)
+    BCM::Worker::start();
+    Model::sync();
+
+    // Profile 0 is PWM, the first algorithm of the engine. Blank bank until a frame arrives.
+    CHECK(run_refresh());
+    fill(&p[0], 1);
+    CHECK(Matrix::Worker::process(&p[0]));
+    engine::poll();
+    CHECK(run_refresh());
+    check_refresh(&p[0], PWM::get_on);
+    const uint64_t pwm_refresh = get_refresh();
+
+    // PWM to BCM, profile 1 is profile 0 of BCM
+    const uint64_t to_bcm = run_switch(1);
+    check_refresh(&p[0], BCM::get_on);
+    const uint64_t bcm_refresh = get_refresh();
+    CHECK(to_bcm <= (pwm_refresh + margin));                        // PWM finished its refresh, BCM started with its blank time
+
+    // Profiles past the last algorithm do not exist, a profile of the displayed algorithm does not switch.
+    CHECK(!Matrix::set_profile(1 + BCM::get_profiles()));
+    CHECK(Matrix::set_profile(1));
+    engine::poll();
+    check_refresh(&p[0], BCM::get_on);
+
+    // BCM to PWM
+    const uint64_t to_pwm = run_switch(0);
+    check_refresh(&p[0], PWM::get_on);
+    CHECK(to_pwm <= (bcm_refresh + margin));
+
+    // Next frame after the switch back
+    fill(&p[1], 2);
+    CHECK(Matrix::Worker::process(&p[1]));
+    engine::poll();
+    CHECK(run_refresh());
+    check_refresh(&p[1], PWM::get_on);
+
+    // Sequence of every row: OE is off while the address changes and rows are in order. (Across both switches)
+    CHECK(Panel::lit_changes == 0);
+    CHECK(Panel::bad_rows == 0);
+    CHECK(Model::errors == 0);
+
+    printf("PWM %.0f us, BCM %.0f us per refresh, refresh across a switch: %.0f us to BCM, %.0f us to PWM\n",
+        pwm_refresh / 125.0, bcm_refresh / 125.0, to_bcm / 125.0, to_pwm / 125.0);
+    return Test::result();
+}
@@ -0,0 +1,22 @@
+/* 
+ * File:   pwm.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include "Serial/config.h"
+#include "Matrix/engine.h"
+#include "Matrix/dot.h"
+#include "Matrix/HUB75/PWM/memory_format.h"
+
+// Expected on time of PWM, built against the PWM memory format. (See matrix.cpp)
+namespace Matrix::PWM {
+    // Lines 0 to v - 1 of the period in PIO cycles (See test/Matrix/HUB75/PWM/matrix.cpp)
+    double get_on(const Serial::pixel *s, uint32_t m, uint16_t r, uint16_t x, uint8_t c) {
+        const uint16_t in[3] = { s->red, s->green, s->blue };
+        const uint16_t v = APP::Dot::apply(Matrix::Worker::color<PWM_bits>.get(c, in[c]), APP::Dot::get(m)[c]);
+
+        return step_table.step_end[v];
+    }
+}
@@ -0,0 +1,190 @@
+/* 
+ * File:   matrix.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <cmath>
+#include "test.h"
+#include "model.h"
+
+// Engine, worker, matrix.cpp and calculator.cpp are built into the test, the hardware is the model. (See model.cpp)
+#include "lib/src/Matrix/HUB75/PWM/Buffer.cpp"
+#include "lib/src/Matrix/HUB75/PWM/worker.cpp"
+#include "lib/src/Matrix/HUB75/PWM/matrix.cpp"
+#include "lib/src/Matrix/HUB75/PWM/calculator.cpp"
+#include "lib/src/Matrix/HUB75/PWM/engine.cpp"
+#include "Matrix/HUB75/panel.h"
+
+using namespace Matrix;
+using namespace Matrix::PWM;
+
+// Waveform test of the PWM algorithm
+//  Rows are sequenced by interrupts, or by the DMA control blocks with DMA_SCAN. (See matrix.cpp)
+//  The panel model counts the on time of every LED over one refresh, line i of the period ends at step_end[i + 1].
+
+static const char *get_path() {
+    return (DMA_SCAN && scan) ? "DMA scan" : ROW_DMA ? "row DMA" : "address table";
+}
+
+// System clock cycles of a PIO cycle
+static double get_divider() {
+    const uint32_t clkdiv = pio0_hw->sm[0].clkdiv;
+    return (clkdiv >> PIO_SM0_CLKDIV_INT_LSB) + (((clkdiv >> PIO_SM0_CLKDIV_FRAC_LSB) & 0xFF) / 256.0);
+}
+
+// Runs until row 0 is lit again
+static bool run_refresh() {
+    const uint32_t r = Panel::refreshes;
+    const uint64_t limit = Model::cycles + (4 * 125000000ull / MIN_REFRESH);
+
+    while ((Panel::refreshes == r) && (Model::cycles < limit))
+        Model::run(1);
+
+    return Panel::refreshes != r;
+}
+
+// Every LED is on for the lines of its value, within a few PIO cycles of the line ends. (Black without a packet)
+static void check_refresh(Serial::packet *p) {
+    static const Serial::pixel black = {};
+    const uint8_t *dot = APP::Dot::get(0);
+    const double divider = get_divider();
+    double error = 0;
+
+    Panel::clear();
+    CHECK(run_refresh());
+    Panel::flush();
+
+    for (uint8_t y = 0; y < MULTIPLEX; y++) {
+        for (uint8_t chain = 0; chain < CHAINS; chain++) {
+            for (uint16_t x = 0; x < COLUMNS; x++) {
+                for (uint8_t half = 0; half < 2; half++) {
+                    const uint16_t r = y + (((chain * 2) + half) * MULTIPLEX);
+                    const Serial::pixel *s = p ? APP::Map::pixel(p, APP::Map::get(r, x)) : &black;
+                    const uint16_t in[3] = { s->red, s->green, s->blue };
+
+                    for (uint8_t c = 0; c < 3; c++) {
+                        const uint16_t v = APP::Dot::apply(PWM::Worker::color.get(c, in[c]), dot[c]);
+                        const double expected = step_table.step_end[v] * divider;
+                        const double on = Panel::on[y][(chain * 6) + (half * 3) + c][x];
+
+                        error = std::max(error, std::abs(on - expected) / divider);
+                    }
+                }
+            }
+        }
+    }
+
+    CHECK(error <= 4);
+}
+
+// Lines above the toe are held for the slope of (i / 2^PWM_bits)^PWM_GAMMA, relative to the last line. (See step_table)
+//  On times above are within a few PIO cycles of step_end, so this is the hold of every line on the panel.
+static void check_gamma() {
+    constexpr uint32_t n = 1 << PWM_bits;
+    const double last = step_table.step_end[n] - step_table.step_end[n - 1];
+    double error = 0;
+    uint32_t toe = 0;
+
+    CHECK(last > line_cycles);
+
+    for (uint32_t i = 0; i < n; i++) {
+        const double hold = step_table.step_end[i + 1] - step_table.step_end[i];
+        const double slope = (pow(i + 1, PWM_GAMMA) - pow(i, PWM_GAMMA)) / (pow(n, PWM_GAMMA) - pow(n - 1, PWM_GAMMA));
+
+        if (hold > line_cycles)
+            error = std::max(error, std::abs(hold - (slope * last)));
+        else
+            toe++;
+    }
+
+    CHECK(toe < n);
+    CHECK(error <= 2);                                  // Lines are whole PIO cycles
+}
+
+static void fill(Serial::packet *p, uint32_t seed) {
+    srand(seed);
+
+    for (uint32_t r = 0; r < (2 * MULTIPLEX * CHAINS); r++)
+        for (uint16_t x = 0; x < COLUMNS; x++) {
+            Serial::pixel *s = (Serial::pixel *) APP::Map::pixel(p, APP::Map::get(r, x));
+            s->red = rand();
+            s->green = rand();
+            s->blue = rand();
+        }
+}
+
+int main() {
+    static PWM::Worker::PWM_worker w;
+    static Serial::packet p[2];
+    constexpr uint32_t refreshes = 20;
+
+    PWM::Worker::row_lock = spin_lock_init(spin_lock_claim_unused(true));
+    Model::watch = Panel::watch;
+    Matrix::start();
+    Model::sync();
+
+    // Blank bank until a frame arrives
+    CHECK(run_refresh());
+    check_refresh(nullptr);
+
+    // Bank is swapped at the start of a refresh
+    for (uint32_t i = 0; i < 2; i++) {
+        fill(&p[i], i + 1);
+        w.process_packet(&p[i]);
+        CHECK(run_refresh());
+        check_refresh(&p[i]);
+    }
+
+    if (PWM_GAMMA != 1.0)
+        check_gamma();
+
+    // Interrupts per refresh
+    //  Interrupt path: End of row and blank timer for every row. DMA_SCAN: Bank swap once per refresh.
+    const Model::interrupts_t before = Model::interrupts;
+    const uint64_t cycles = Model::cycles;
+    const uint64_t ns = Model::isr_ns;
+
+    for (uint32_t i = 0; i < refreshes; i++)
+        CHECK(run_refresh());
+
+    const uint32_t pio = Model::interrupts.pio - before.pio;
+    const uint32_t dma = Model::interrupts.dma - before.dma;
+    const uint32_t timer = Model::interrupts.timer - before.timer;
+    const double refresh = (125000000.0 * refreshes) / (Model::cycles - cycles);
+    const double per_refresh = (double) (pio + dma + timer) / refreshes;
+
+    if (DMA_SCAN && scan)
+        CHECK((pio == 0) && (timer == 0) && (dma == refreshes));
+    else
+        CHECK((pio == (refreshes * MULTIPLEX * Table::scans)) && (timer == pio) && (dma == 0));
+
+    // Sequence of every row: OE is off while the address changes and rows are in order.
+    CHECK(Panel::lit_changes == 0);
+    CHECK(Panel::bad_rows == 0);
+
+    // Blank time is the one of get_refresh_overhead, the first line of the row is shifted while OE is off. (See calculator.cpp)
+    //  Blank timer has one microsecond resolution, end of row and latch take a few PIO cycles.
+    const double period_us = 1000000.0 / (MULTIPLEX * MIN_REFRESH);
+    const double blank_us = period_us - (period_us / Calculator::get_refresh_overhead());
+    CHECK((Panel::min_blank_clocks == line_columns) && (Panel::max_blank_clocks == line_columns));
+    CHECK(Panel::min_blank >= (blank_us * 125));
+    CHECK(Panel::max_blank <= (((blank_us + 1) * 125) + (10 * get_divider())));
+
+    // End of row is the PIO IRQ after the last line is latched, OE goes off a few PIO cycles later. (No FIFO delay)
+    CHECK(Panel::max_latch_off <= (8 * get_divider()));
+    CHECK(Model::errors == 0);
+
+    // Core 1 takes every interrupt, the worker gets the cycles back. (At least the exception entry of the Cortex-M0+)
+    printf("%s: %.0f Hz refresh, %.2f interrupts per refresh, %.0f interrupts per second, %.0f ns host time per refresh in the ISRs\n",
+        get_path(), refresh, per_refresh, per_refresh * refresh, (double) (Model::isr_ns - ns) / refreshes);
+
+    if (DMA_SCAN && scan)
+        printf("%s: %.0f interrupts per second and at least %.0f worker cycles per second reclaimed from the interrupt path\n",
+            get_path(), ((2.0 * MULTIPLEX) - per_refresh) * refresh, ((2.0 * MULTIPLEX) - per_refresh) * refresh * 15);
+
+    return Test::result();
+}
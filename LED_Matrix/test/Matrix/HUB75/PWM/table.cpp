@@ -0,0 +1,67 @@
+/* 
+ * File:   table.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include "Matrix/HUB75/PWM/memory_format.h"
+#include "test.h"
+
+// Every line of the PWM period has its own entry in the address table (Permutation)
+template <typename T> static void test_permutation() {
+    static bool seen[T::scans][T::lines];
+    bool ok = (T::scans * T::lines) == (1 << Matrix::PWM::PWM_bits);
+
+    memset(seen, 0, sizeof(seen));
+
+    for (uint32_t i = 0; i < (1 << Matrix::PWM::PWM_bits); i++) {
+        const uint32_t s = T::get_scan(i);
+        const uint32_t j = T::get_line(i);
+
+        ok &= (s < T::scans) && (j < T::lines);
+
+        if ((s < T::scans) && (j < T::lines)) {
+            ok &= !seen[s][j];
+            seen[s][j] = true;
+        }
+    }
+
+    CHECK(ok);
+}
+
+// Worker turns a value v on for lines 0 to v - 1 of the PWM period (See PWM/worker.cpp)
+//  Every scan must show these at its start, v / scans lines each and one more for part of the scans.
+//      SPWM: Scan s is on for floor((v + s) / SUB_PERIODS) lines.
+template <typename T> static void test_on_time() {
+    bool ok = true;
+
+    for (uint32_t v = 0; v <= ((1 << Matrix::PWM::PWM_bits) - 1); v++) {
+        uint32_t on[T::scans] = {};
+        uint32_t last[T::scans] = {};
+
+        for (uint32_t i = 0; i < v; i++) {
+            on[T::get_scan(i)]++;
+            last[T::get_scan(i)] = T::get_line(i) + 1;
+        }
+
+        for (uint32_t s = 0; s < T::scans; s++) {
+            ok &= last[s] == on[s];                                 // No gaps, a single on time per scan
+            ok &= on[s] == ((v + s) / T::scans);
+        }
+    }
+
+    CHECK(ok);
+}
+
+int main() {
+    CHECK((std::is_same<Matrix::PWM::Table, Matrix::PWM::DEFINE_MATRIX_PWM_TABLE>::value));
+
+    test_permutation<Matrix::PWM::PWM_table>();
+    test_permutation<Matrix::PWM::SPWM_table>();
+    test_on_time<Matrix::PWM::PWM_table>();
+    test_on_time<Matrix::PWM::SPWM_table>();
+    return Test::result();
+}
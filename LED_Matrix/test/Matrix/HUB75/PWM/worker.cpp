@@ -0,0 +1,140 @@
+/* 
+ * File:   worker.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "test.h"
+
+// Worker and buffer are built into the test, the address table normally lives in matrix.cpp.
+#include "lib/src/Matrix/HUB75/PWM/Buffer.cpp"
+#include "lib/src/Matrix/HUB75/PWM/worker.cpp"
+
+namespace Matrix::PWM {
+    address_table_t address_table[Serial::num_framebuffers];
+    volatile uint8_t null_table[line_length];
+}
+
+// Calculator is not built into the test, a configuration which does not fit would write past the banks. (See calculator.cpp)
+static_assert((Matrix::PWM::levels_size + (Matrix::MULTIPLEX * Matrix::PWM::row_length)) <= Serial::max_framebuffer_size, "Configuration of the test does not fit the buffer");
+
+using namespace Matrix;
+using namespace Matrix::PWM;
+using namespace Matrix::PWM::Worker;
+
+// Line i of the PWM period as the DMA sees it (See set_table)
+static const volatile uint8_t *get_period_line(uint8_t b, uint8_t y, uint32_t i) {
+    return address_table[b][((Table::get_scan(i) * MULTIPLEX) + y) * table_entries + Table::get_line(i)].data;
+}
+
+static bool get_channel(const volatile uint8_t *line, uint16_t x, uint8_t chain, uint8_t k) {
+    if (line == null_table)
+        return false;
+
+    const volatile line_t *element = (const volatile line_t *) (line + PWM::Buffer::get_column_offset()) + x;
+    return (*element >> ((6 * chain) + k)) & 1;
+}
+
+// Every channel is on for its value of the 2^PWM_bits lines of the period.
+//  PWM and SPWM: Channel is on for lines 0 to v - 1 of the period. (See table.cpp for the order of the scans)
+//  HYBRID: Low bits and bitplanes are not a single on time, only the count is checked.
+static void check_frame(Serial::packet *p) {
+    const uint8_t b = bank_last;
+    const uint8_t *dot = APP::Dot::get(0);
+    bool ok = true;
+
+    for (uint8_t y = 0; y < MULTIPLEX; y++) {
+        for (uint8_t chain = 0; chain < CHAINS; chain++) {
+            for (uint16_t x = 0; x < COLUMNS; x++) {
+                for (uint8_t half = 0; half < 2; half++) {
+                    const uint16_t r = y + (((chain * 2) + half) * MULTIPLEX);
+                    const Serial::pixel *s = APP::Map::pixel(p, APP::Map::get(r, x));
+                    const uint16_t in[3] = { s->red, s->green, s->blue };
+
+                    for (uint8_t c = 0; c < 3; c++) {
+                        const uint16_t v = APP::Dot::apply(color.get(c, in[c]), dot[c]);
+                        uint32_t on = 0;
+
+                        for (uint32_t i = 0; i < (1 << PWM_bits); i++) {
+                            const bool bit = get_channel(get_period_line(b, y, i), x, chain, (half * 3) + c);
+
+                            on += bit;
+
+                            if constexpr (BCM_bits == 0)
+                                ok &= bit == (i < v);
+                        }
+
+                        ok &= on == v;
+                    }
+                }
+            }
+        }
+    }
+
+    CHECK(ok);
+}
+
+static void fill(Serial::packet *p, uint32_t seed) {
+    srand(seed);
+
+    for (uint32_t r = 0; r < (2 * MULTIPLEX * CHAINS); r++)
+        for (uint16_t x = 0; x < COLUMNS; x++) {
+            Serial::pixel *s = (Serial::pixel *) APP::Map::pixel(p, APP::Map::get(r, x));
+            s->red = rand();
+            s->green = rand();
+            s->blue = rand();
+        }
+}
+
+int main() {
+    static PWM_worker w;
+    static Serial::packet p[3];
+    constexpr uint32_t frames = 1000;
+    constexpr uint32_t pixels = 2 * MULTIPLEX * CHAINS * COLUMNS;
+
+    row_lock = spin_lock_init(spin_lock_claim_unused(true));
+
+    // Black, a converted frame, a frame with one row changed (Copied rows) and the first frame again (Skipped rows)
+    memset(&p[0], 0, sizeof(p[0]));
+    w.process_packet(&p[0]);
+    check_frame(&p[0]);
+
+    fill(&p[0], 1);
+    w.process_packet(&p[0]);
+    check_frame(&p[0]);
+
+    memcpy(&p[1], &p[0], sizeof(p[0]));
+    ((Serial::pixel *) APP::Map::pixel(&p[1], APP::Map::get(MULTIPLEX - 1, 0)))->red ^= 0xFF;
+    w.process_packet(&p[1]);
+    check_frame(&p[1]);
+    CHECK(stats.rows_copied != 0);
+
+    w.process_packet(&p[0]);
+    check_frame(&p[0]);
+    CHECK(stats.rows_skipped != 0);
+
+    for (uint32_t i = 2; i < 10; i++) {
+        fill(&p[i % 2], i);
+        w.process_packet(&p[i % 2]);
+        check_frame(&p[i % 2]);
+    }
+
+    // Benchmark: Every row of every frame is converted (Includes the row hashes)
+    //  Nothing takes the banks, the worker alternates between two. Three frames keep every row dirty.
+    //  Lookup table of the previous worker was 2^PWM_bits * 6 * 2^PWM_bits bytes, printed for comparison.
+    fill(&p[2], 10);
+    const uint32_t converted = stats.rows_converted;
+    const uint64_t start = Test::now_ns();
+
+    for (uint32_t i = 0; i < frames; i++)
+        w.process_packet(&p[(i + 2) % 3]);
+
+    const double ns = (double) (Test::now_ns() - start) / (frames * pixels);
+
+    CHECK((stats.rows_converted - converted) == (frames * MULTIPLEX));             // Nothing was skipped or copied
+    check_frame(&p[(frames + 1) % 3]);
+    printf("PWM_bits %u, %u columns: %.2f ns/pixel, lookup table would be %u KB\n", PWM_bits, COLUMNS, ns, ((1 << PWM_bits) * 6 * (1 << PWM_bits)) / 1024);
+    return Test::result();
+}
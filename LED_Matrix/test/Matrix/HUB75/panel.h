@@ -0,0 +1,187 @@
+/* 
+ * File:   panel.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_MATRIX_HUB75_PANEL_H
+#define TEST_MATRIX_HUB75_PANEL_H
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include "model.h"
+#include "Matrix/HUB75/hw_config.h"
+#include "Multiplex/HUB75/hw_config.h"
+
+// Model of a HUB75 panel on the pins of the hardware model (See test/model.h)
+//  Every data pin shifts into a register of COLUMNS on the rising CLK edge, column x is the x-th of the last COLUMNS bits shifted.
+//  Latch is transparent while LAT is high, the row selected by the address pins shows the latch while OE is low.
+//  On time of every LED is counted in system clock cycles, a row is counted when OE goes low on a new address.
+//  OE low pulses of a row are timed by their order, BCM pulses every bitplane once. (See BCM/matrix.cpp)
+namespace Panel {
+    constexpr uint32_t channels = 6 * Matrix::CHAINS;
+    constexpr uint32_t data_mask = (1 << channels) - 1;
+    constexpr uint32_t clk_pin = Matrix::HUB75::HUB75_CLK;
+    constexpr uint32_t lat_pin = Matrix::HUB75::HUB75_CLK + 1;
+    constexpr uint32_t oe_pin = Matrix::HUB75::HUB75_OE;
+
+    inline uint8_t shift[channels][Matrix::COLUMNS];
+    inline uint8_t latch[channels][Matrix::COLUMNS];
+    inline uint32_t head = 0;                           // Oldest bit of the shift registers
+    inline uint64_t on[Matrix::MULTIPLEX][channels][Matrix::COLUMNS];
+
+    inline uint32_t last = 1 << oe_pin;                 // Pins of the previous call
+    inline uint32_t lit_row = Matrix::MULTIPLEX - 1;    // Row shown by the last OE low
+    inline uint64_t since = 0;                          // Start of the current on time
+    inline uint64_t oe_off = 0;                         // Time OE went high
+    inline uint64_t lat_on = 0;                         // Time of the last LAT rising edge
+    inline uint64_t oe_on = 0;                          // Time OE went low
+    inline uint64_t refresh_on = 0;                     // Time row 0 was lit
+
+    // Counts
+    inline uint32_t clocks = 0;                         // CLK rising edges
+    inline uint32_t latches = 0;                        // LAT rising edges
+    inline uint32_t rows = 0;                           // Rows lit
+    inline uint32_t refreshes = 0;                      // Row 0 lit
+    inline uint32_t bad_rows = 0;                       // Lit row is not the next row
+    inline uint32_t lit_changes = 0;                    // Address changes with OE low (Ghosting)
+    inline uint32_t row_clocks = 0;                     // CLK rising edges since the row was lit
+    inline uint32_t min_row_clocks = ~0u;
+    inline uint32_t max_row_clocks = 0;
+    inline uint32_t row_pulses = 0;                     // OE low pulses since the row was lit
+    inline uint32_t max_row_pulses = 0;
+    constexpr uint32_t max_pulses = 16;
+    inline uint64_t min_pulse[max_pulses];              // Shortest and longest i-th OE low pulse of a row
+    inline uint64_t max_pulse[max_pulses];
+    inline uint64_t min_blank = ~0ull;                  // Shortest and longest OE high before the next row is lit
+    inline uint64_t max_blank = 0;
+    inline uint32_t blank_clocks = 0;                   // CLK rising edges since OE went high
+    inline uint32_t min_blank_clocks = ~0u;             // Fewest and most CLK rising edges while OE is high before the next row is lit
+    inline uint32_t max_blank_clocks = 0;
+    inline uint64_t max_latch_off = 0;                  // Longest time from a LAT rising edge to OE high
+    inline uint64_t min_refresh = ~0ull;                // Shortest and longest time from row 0 lit to row 0 lit
+    inline uint64_t max_refresh = 0;
+
+    inline uint32_t get_row(uint32_t pins) {
+        return (pins >> Multiplex::HUB75::HUB75_ADDR_BASE) & ((1 << Multiplex::HUB75::HUB75_ADDR_LEN) - 1);
+    }
+
+    inline bool is_lit(uint32_t pins) {
+        return ((pins >> oe_pin) & 1) == 0;
+    }
+
+    // Adds the on time since the last change of the lit row or its latch
+    inline void flush() {
+        const uint32_t row = get_row(last);
+
+        if (is_lit(last) && (row < Matrix::MULTIPLEX))
+            for (uint32_t c = 0; c < channels; c++)
+                for (uint32_t x = 0; x < Matrix::COLUMNS; x++)
+                    on[row][c][x] += latch[c][x] ? (Model::cycles - since) : 0;
+
+        since = Model::cycles;
+    }
+
+    // Restarts the counts of the on time, blank time and clocks
+    inline void clear() {
+        flush();
+        memset(on, 0, sizeof(on));
+        min_blank = ~0ull;
+        max_blank = 0;
+        min_blank_clocks = ~0u;
+        max_blank_clocks = 0;
+        max_latch_off = 0;
+        min_refresh = ~0ull;
+        max_refresh = 0;
+        min_row_clocks = ~0u;
+        max_row_clocks = 0;
+        max_row_pulses = 0;
+        memset(min_pulse, 0xFF, sizeof(min_pulse));
+        memset(max_pulse, 0, sizeof(max_pulse));
+    }
+
+    inline void watch(uint32_t pins) {
+        const uint32_t changed = pins ^ last;
+        const uint32_t row = get_row(pins);
+
+        if (changed == 0)
+            return;
+
+        if (((pins >> clk_pin) & 1) && ((changed >> clk_pin) & 1)) {
+            const uint32_t data = (pins >> Matrix::HUB75::HUB75_DATA_BASE) & data_mask;
+
+            for (uint32_t c = 0; c < channels; c++)
+                shift[c][head] = (data >> c) & 1;
+
+            head = (head + 1) % Matrix::COLUMNS;
+            clocks++;
+            row_clocks++;
+            blank_clocks++;
+        }
+
+        if (changed & ~(1u << clk_pin))
+            flush();
+
+        if (((pins >> lat_pin) & 1) && ((changed >> lat_pin) & 1)) {
+            lat_on = Model::cycles;
+            latches++;
+        }
+
+        if ((pins >> lat_pin) & 1)
+            for (uint32_t c = 0; c < channels; c++)
+                for (uint32_t x = 0; x < Matrix::COLUMNS; x++)
+                    latch[c][x] = shift[c][(head + x) % Matrix::COLUMNS];
+
+        if (is_lit(last) && is_lit(pins) && (row != get_row(last)))
+            lit_changes++;
+
+        if (!is_lit(last) && is_lit(pins))
+            oe_on = Model::cycles;
+
+        if (is_lit(last) && !is_lit(pins)) {
+            if (row_pulses < max_pulses) {
+                min_pulse[row_pulses] = std::min(min_pulse[row_pulses], Model::cycles - oe_on);
+                max_pulse[row_pulses] = std::max(max_pulse[row_pulses], Model::cycles - oe_on);
+            }
+
+            row_pulses++;
+            max_latch_off = std::max(max_latch_off, Model::cycles - lat_on);
+            oe_off = Model::cycles;
+            blank_clocks = 0;
+        }
+
+        // Row starts when it is lit, the address pins may pass other rows while they change.
+        if (!is_lit(last) && is_lit(pins) && (row != lit_row)) {
+            const uint64_t blank = Model::cycles - oe_off;
+
+            bad_rows += (row != ((lit_row + 1) % Matrix::MULTIPLEX));
+
+            if (row == 0) {
+                if (refreshes != 0) {
+                    min_refresh = std::min(min_refresh, Model::cycles - refresh_on);
+                    max_refresh = std::max(max_refresh, Model::cycles - refresh_on);
+                }
+
+                refresh_on = Model::cycles;
+                refreshes++;
+            }
+
+            min_blank = std::min(min_blank, blank);
+            max_blank = std::max(max_blank, blank);
+            min_blank_clocks = std::min(min_blank_clocks, blank_clocks);
+            max_blank_clocks = std::max(max_blank_clocks, blank_clocks);
+            min_row_clocks = std::min(min_row_clocks, row_clocks);
+            max_row_clocks = std::max(max_row_clocks, row_clocks);
+            max_row_pulses = std::max(max_row_pulses, row_pulses);
+            row_clocks = 0;
+            row_pulses = 0;
+            lit_row = row;
+            rows++;
+        }
+
+        last = pins;
+    }
+}
+
+#endif
@@ -0,0 +1,67 @@
+/* 
+ * File:   color.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include "Matrix/color.h"
+#include "test.h"
+
+// Generated tables (4 to 12 PWM bits)
+//  Gamma 1.0 without balance must be the linear scale the workers used before the tables.
+//  Otherwise the tables must keep both ends and never decrease.
+template <uint8_t bits> static void test_tables() {
+    static APP::Color<bits> color;
+    constexpr bool linear = (Matrix::COLOR_GAMMA == 1.0) && (Matrix::COLOR_BALANCE[0] == 1.0) && (Matrix::COLOR_BALANCE[1] == 1.0) && (Matrix::COLOR_BALANCE[2] == 1.0);
+    constexpr uint32_t scale = 1 << (bits + Matrix::COLOR_DITHER);
+
+    for (uint8_t c = 0; c < 3; c++) {
+        bool ok = color.get(c, 0) == 0;
+
+        for (uint32_t v = 1; v < Serial::range_high; v++) {
+            if (linear)
+                ok &= color.get(c, v) == ((v * scale) / Serial::range_high);
+            else
+                ok &= color.get(c, v) >= color.get(c, v - 1);
+        }
+
+        const uint32_t top = (uint32_t) ((((Serial::range_high - 1.0) * Matrix::COLOR_BALANCE[c]) * scale) / Serial::range_high);
+        ok &= color.get(c, Serial::range_high - 1) == ((top > APP::Color<bits>::max) ? APP::Color<bits>::max : top);
+
+        if (!ok)
+            printf("color: table %u of %u bits\n", c, bits);
+
+        CHECK(ok);
+    }
+}
+
+// Upload handshake (Producer is refused until the consumer swapped)
+static void test_load() {
+    static APP::Color<8> color;
+    static uint16_t src[3 * APP::Color<8>::size];
+
+    for (uint32_t i = 0; i < (3 * APP::Color<8>::size); i++)
+        src[i] = 0xFFFF - i;
+
+    const uint16_t before = color.get(0, 1);
+
+    CHECK(!color.update());
+    CHECK(color.load(src));
+    CHECK(!color.load(src));
+    CHECK(color.get(0, 1) == before);           // Front bank is untouched until the swap
+    CHECK(color.update());
+    CHECK(!color.update());
+    CHECK(color.get(0, 1) == APP::Color<8>::max);   // Clamped to the PWM range
+    CHECK(color.load(src));
+}
+
+int main() {
+    test_tables<4>();
+    test_tables<6>();
+    test_tables<8>();
+    test_tables<10>();
+    test_tables<12>();
+    test_load();
+    return Test::result();
+}
@@ -0,0 +1,62 @@
+/* 
+ * File:   dither.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include "Matrix/dither.h"
+#include "test.h"
+
+// Ordered dither keeps the mean of every 4x4 tile
+//  Thresholds of a tile are uniform, so the values of a tile add up to 16 / 2^COLOR_DITHER times the input.
+//      Values clamped at the top are excluded.
+//  With COLOR_DITHER 0 the stage passes values through.
+template <uint8_t bits> static void test_mean() {
+    typedef APP::Dither<bits> D;
+    constexpr uint32_t steps = 1 << D::frac;
+    bool ok = true;
+
+    for (uint32_t v = 0; v < ((D::max + 1) * steps); v++) {
+        uint32_t sum = 0;
+        bool clamped = false;
+
+        for (uint16_t r = 0; r < 4; r++) {
+            for (uint16_t x = 0; x < 4; x++) {
+                const uint8_t t = D::get(r + 8, x + 4);     // Pattern repeats every 4 positions
+
+                ok &= t == D::get(r, x);
+                ok &= t < steps;
+                clamped |= ((v + t) >> D::frac) > D::max;
+                sum += D::apply(v, t);
+            }
+        }
+
+        if (!clamped)
+            ok &= sum == ((16 * v) / steps);
+
+        if (D::frac == 0)
+            ok &= D::apply(v, D::get(1, 2)) == v;
+    }
+
+    CHECK(ok);
+}
+
+// Top of the range never wraps
+template <uint8_t bits> static void test_clamp() {
+    typedef APP::Dither<bits> D;
+    const uint32_t top = ((D::max + 1) << D::frac) - 1;
+
+    for (uint16_t r = 0; r < 4; r++)
+        for (uint16_t x = 0; x < 4; x++)
+            CHECK(D::apply(top, D::get(r, x)) == D::max);
+}
+
+int main() {
+    test_mean<4>();
+    test_mean<8>();
+    test_mean<12>();
+    test_clamp<4>();
+    test_clamp<12>();
+    return Test::result();
+}
@@ -0,0 +1,64 @@
+/* 
+ * File:   map.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "Matrix/map.h"
+#include "test.h"
+
+// Every shift position gathers a different pixel of the logical image (Permutation)
+static void test_permutation() {
+    static bool seen[APP::Map::rows * Matrix::COLUMNS];
+    bool ok = (APP::Map::width * APP::Map::height) == (APP::Map::rows * Matrix::COLUMNS);
+
+    memset(seen, 0, sizeof(seen));
+
+    for (uint16_t r = 0; r < APP::Map::rows; r++) {
+        for (uint16_t x = 0; x < Matrix::COLUMNS; x++) {
+            const uint32_t i = APP::Map::get(r, x);
+
+            ok &= i < (APP::Map::rows * Matrix::COLUMNS);
+
+            if (i < (APP::Map::rows * Matrix::COLUMNS)) {
+                ok &= !seen[i];
+                seen[i] = true;
+            }
+        }
+    }
+
+    CHECK(ok);
+}
+
+// Known positions of the configurations in CMakeLists.txt
+static void test_positions() {
+    if constexpr (APP::Map::identity) {
+        for (uint16_t r = 0; r < APP::Map::rows; r++)
+            for (uint16_t x = 0; x < Matrix::COLUMNS; x++)
+                CHECK(APP::Map::get(r, x) == ((r * (uint32_t) Matrix::COLUMNS) + x));
+    }
+    else if constexpr ((Matrix::PIXEL_LAYOUT == 1) && (Matrix::PIXEL_ROTATION == 0)) {
+        // First block goes to the lower panel row of the scan row, the next block to the upper one
+        CHECK(APP::Map::get(0, 0) == (Matrix::MULTIPLEX * APP::Map::width));
+        CHECK(APP::Map::get(0, Matrix::PIXEL_BLOCK) == 0);
+        CHECK(APP::Map::get(1, Matrix::PIXEL_BLOCK + 1) == (APP::Map::width + 1));
+    }
+    else if constexpr (Matrix::PIXEL_LAYOUT == 2) {
+        // Every other group of blocks starts at the upper panel row, rotated by 90 degrees
+        CHECK(APP::Map::get(0, 0) == (((APP::Map::panel_width - 1) * APP::Map::width) + Matrix::MULTIPLEX));
+        CHECK(APP::Map::get(0, 2 * Matrix::PIXEL_BLOCK) == ((APP::Map::panel_width - 1 - Matrix::PIXEL_BLOCK) * APP::Map::width));
+    }
+    else if constexpr ((Matrix::PIXEL_ROTATION == 270) && (Matrix::PIXEL_MIRROR == 3)) {
+        // Mirrored both ways, then rotated by 270 degrees
+        CHECK(APP::Map::get(0, 0) == ((Matrix::COLUMNS - 1) * APP::Map::width));
+        CHECK(APP::Map::get(APP::Map::rows - 1, 0) == (((Matrix::COLUMNS - 1) * APP::Map::width) + APP::Map::rows - 1));
+    }
+}
+
+int main() {
+    test_permutation();
+    test_positions();
+    return Test::result();
+}
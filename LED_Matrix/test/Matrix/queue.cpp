@@ -0,0 +1,93 @@
+/* 
+ * File:   queue.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include "Matrix/queue.h"
+#include "test.h"
+
+// Single thread semantics of APP::Ring
+static void test_order() {
+    APP::Ring<uint32_t, 4> ring;
+    uint32_t v = 0;
+
+    CHECK(!ring.front(&v));
+    CHECK(ring.push(1));
+    CHECK(ring.front(&v) && (v == 1));
+    CHECK(ring.depth() == 1);                   // Entry taken by front keeps its slot
+    ring.pop();
+    CHECK(ring.depth() == 0);
+    CHECK(!ring.front(&v));
+
+    // Consumer skips to the newest entry, the rest are coalesced
+    CHECK(ring.push(2) && ring.push(3) && ring.push(4));
+    CHECK(ring.front(&v) && (v == 4));
+    CHECK(ring.get_coalesced() == 2);
+    CHECK(ring.get_depth_max() == 3);
+    ring.pop();
+
+    // Full ring rejects, the entry being converted counts against the size
+    CHECK(ring.push(5));
+    CHECK(ring.front(&v) && (v == 5));
+    CHECK(ring.push(6) && ring.push(7) && ring.push(8));
+    CHECK(!ring.push(9));
+    CHECK(ring.get_rejected() == 1);
+    ring.pop();
+    CHECK(ring.push(9));
+    CHECK(ring.front(&v) && (v == 9));
+    ring.pop();
+}
+
+// Producer and consumer threads
+//  Every accepted entry is either taken or coalesced, taken entries only increase.
+static void test_threads() {
+    constexpr uint32_t count = 1000000;
+    static APP::Ring<uint32_t, 4> ring;
+    std::atomic<bool> done = {false};
+    uint32_t accepted = 0;
+    uint32_t taken = 0;
+    uint32_t last = 0;
+    bool ordered = true;
+
+    std::thread producer([&]() {
+        for (uint32_t i = 1; i <= count; i++) {
+            if (ring.push(i))
+                accepted++;
+        }
+
+        done.store(true, std::memory_order_release);
+    });
+
+    while (true) {
+        const bool finished = done.load(std::memory_order_acquire);
+        uint32_t v;
+
+        while (ring.front(&v)) {
+            ordered &= v > last;
+            last = v;
+            taken++;
+            ring.pop();
+        }
+
+        if (finished)
+            break;
+    }
+
+    producer.join();
+
+    CHECK(ordered);
+    CHECK((accepted + ring.get_rejected()) == count);
+    CHECK((taken + ring.get_coalesced()) == accepted);
+    CHECK(ring.get_depth_max() <= 4);
+    printf("queue: %u accepted, %u taken, %u coalesced, %u rejected\n", accepted, taken, ring.get_coalesced(), ring.get_rejected());
+}
+
+int main() {
+    test_order();
+    test_threads();
+    return Test::result();
+}
@@ -0,0 +1,95 @@
+/* 
+ * File:   data_node.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include <deque>
+#include <random>
+#include "hardware/gpio.h"
+#include "hardware/uart.h"
+#include "Matrix/queue.h"
+#include "Serial/Node/data.h"
+#include "test.h"
+
+// UART data node is linked in, the hardware it touches is not used by the rotation
+uart_hw_t *uart0_hw = nullptr;
+uart_inst_t *uart0 = nullptr;
+void gpio_init(uint gpio) {}
+void gpio_set_dir(uint gpio, bool out) {}
+void gpio_set_function(uint gpio, gpio_function fn) {}
+uint uart_init(uart_inst_t *uart, uint baudrate) { return baudrate; }
+bool uart_is_readable(uart_inst_t *uart) { return false; }
+char uart_getc(uart_inst_t *uart) { return 0; }
+void uart_putc(uart_inst_t *uart, char c) {}
+
+// Rotation which advanced on every packet, regardless of the worker (Before commit)
+static Serial::packet old_buffers[Serial::num_packets];
+static uint8_t old_buffer = 0;
+
+static void old_callback(Serial::packet **buf) {
+    *buf = &old_buffers[(old_buffer + 1) % Serial::num_packets];
+    old_buffer = (old_buffer + 1) % Serial::num_packets;
+}
+
+static void old_commit(Serial::packet *buf) {}
+
+// Protocol and worker driven in a random interleave
+//  Protocol fills the buffer from the data node, then hands frames to the ring of the worker. (See Matrix::Worker::process)
+//      Some commands are not frames and are never handed over.
+//  Worker takes the newest frame, converts it and pops it. (Older frames are coalesced)
+//  Returns the number of times the data node handed out a buffer still owned by the ring.
+static uint32_t run(void (*callback)(Serial::packet **), void (*commit)(Serial::packet *), uint32_t seed, uint32_t *rejected) {
+    APP::Ring<Serial::packet *, Serial::num_packets - 2> queue;
+    std::deque<Serial::packet *> owned;                 // Accepted and not yet released, oldest first
+    std::mt19937 rng(seed);
+    Serial::packet *converting = nullptr;
+    uint32_t collisions = 0;
+
+    for (uint32_t i = 0; i < 200000; i++) {
+        if (rng() % 2) {
+            Serial::packet *p;
+
+            callback(&p);
+
+            for (Serial::packet *o : owned)
+                collisions += o == p;
+
+            if ((rng() % 8) != 0) {
+                if (queue.push(p)) {
+                    owned.push_back(p);
+                    commit(p);
+                }
+            }
+        }
+        else if (converting == nullptr) {
+            if (queue.front(&converting))
+                owned.erase(owned.begin(), owned.end() - 1);    // Newest is taken, the rest are coalesced
+        }
+        else if ((rng() % 4) == 0) {                    // Conversion is slower than a packet
+            owned.pop_front();
+            queue.pop();
+            converting = nullptr;
+        }
+    }
+
+    *rejected = queue.get_rejected();
+    return collisions;
+}
+
+int main() {
+    uint32_t rejected;
+
+    // Rejected frames keep their buffer, the rotation never reaches a buffer the ring owns
+    for (uint32_t seed = 1; seed <= 8; seed++) {
+        CHECK(run(Serial::Node::Data::callback, Serial::Node::Data::commit, seed, &rejected) == 0);
+        CHECK(rejected > 0);
+    }
+
+    printf("data_node: %u frames rejected without reuse\n", rejected);
+
+    // Check would have caught the old rotation
+    CHECK(run(old_callback, old_commit, 1, &rejected) > 0);
+    return Test::result();
+}
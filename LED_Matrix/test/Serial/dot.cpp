@@ -0,0 +1,123 @@
+/* 
+ * File:   dot.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "test.h"
+
+// Command is built into the test, the data node is replaced by the bytes of the test. (See get_data)
+#include "lib/src/Serial/Protocol/Serial/Command/Data/Dot/Dot.cpp"
+
+using namespace Serial::Protocol::DATA_NODE;
+using Serial::Protocol::internal::STATUS;
+
+// -- Command.cpp --
+
+namespace Serial::Protocol::DATA_NODE {
+    Serial::packet *Command::buf = 0;
+    uint16_t Command::len = 0;
+    Command::DATA_STATES Command::state_data = DATA_STATES::SETUP;
+    uint8_t Command::idle_num = 0;
+    uint32_t Command::index;
+    SIMD::SIMD_SINGLE<uint32_t> Command::data;
+    uint32_t Command::checksum;
+    STATUS Command::status;
+    bool Command::trigger;
+    bool Command::acknowledge;
+    uint64_t Command::time;
+    Command *Command::ptr = nullptr;
+
+    static const uint8_t *input;
+
+    void Command::error() {
+        state_data = DATA_STATES::ERROR;
+    }
+
+    void Command::get_data(uint8_t *buf, uint16_t len, bool checksum) {
+        while (index < len) {
+            buf[index] = input[index];
+            index++;
+        }
+    }
+
+    void Command::callback() {
+        ptr = this;
+        process_command_internal();
+    }
+}
+
+// -- Matrix --
+
+static uint16_t written_page;
+static uint8_t written[Dot::size];
+static uint32_t writes = 0;
+
+bool Matrix::Worker::set_dot(uint16_t page, const uint8_t *data) {
+    written_page = page;
+    memcpy(written, data, Dot::size);
+    writes++;
+    return true;
+}
+
+// Runs the states of Command::data_node which belong to the command
+struct Upload : public Dot {
+    // Header of the host, as documented (See doc/Application_Infomation.md)
+    //  Bytes 8 to 13 are the ones of a frame header, the page is big endian in bytes 14 and 15.
+    static void header(uint16_t num) {
+        data.l[0] = htonl(0xAAEEAAEE);
+        data.b[4] = 'k';
+        data.b[5] = 'c';
+        data.s[3] = htons(size);
+        data.b[8] = sizeof(Serial::DEFINE_SERIAL_RGB_TYPE);
+        data.b[9] = Matrix::MULTIPLEX * Matrix::CHAINS;
+        data.s[5] = htons(Matrix::COLUMNS);
+        data.b[12] = Serial::DEFINE_SERIAL_RGB_TYPE::id;
+        data.b[13] = 0;
+        data.b[14] = num >> 8;
+        data.b[15] = num & 0xFF;
+    }
+
+    static bool run(uint16_t num, const uint8_t *payload) {
+        static Upload dot;
+
+        header(num);
+        dot.process_command_internal();
+
+        if (state_data != DATA_STATES::PAYLOAD)
+            return false;
+
+        input = payload;
+        dot.process_payload_internal();
+
+        if (state_data != DATA_STATES::CHECKSUM_DELIMITER_PROCESS)
+            return false;
+
+        checksum = 0xFFFFFFFF;
+        data.l[0] = htonl(~checksum);
+        dot.process_frame_internal();
+        return state_data == DATA_STATES::SETUP;
+    }
+};
+
+int main() {
+    static uint8_t payload[Dot::size];
+    const uint16_t pages[] = { 0, 1, 0x0102, 0x01FF };
+
+    for (uint16_t num : pages) {
+        const uint32_t w = writes;
+
+        for (uint32_t i = 0; i < Dot::size; i++)
+            payload[i] = i + num;
+
+        // Page of the reserved bytes arrives, not the RGB type size and the rows of bytes 8 and 9
+        CHECK(Upload::run(num, payload));
+        CHECK(writes == (w + 1));
+        CHECK(written_page == num);
+        CHECK(memcmp(written, payload, Dot::size) == 0);
+    }
+
+    return Test::result();
+}
@@ -0,0 +1,882 @@
+/* 
+ * File:   model.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <string.h>
+#include <deque>
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/timer.h"
+#include "hardware/structs/bus_ctrl.h"
+#include "hardware/structs/iobank0.h"
+#include "Matrix/matrix.h"
+#include "model.h"
+#include "test.h"
+
+// Hardware model of the RP2040 (See model.h)
+//  Field positions, instruction encodings and DREQ numbers are the ones of the RP2040 datasheet. (See stub/hardware)
+//  Registers are plain memory, writes with side effects are applied after the CPU wrote them. (See sync)
+//      PIO IRQ, DMA INTR and timer INTR are write one to clear, the ISR finds them zeroed and the model clears what was written.
+//  DMA registers only hold 32-bit addresses, the channel addresses are kept by the model as host pointers.
+//      Control blocks written into the registers of another channel are copied whole, the layout is the host struct.
+//          Four words into READ_ADDR to CTRL_TRIG are a scan_block, two words into AL3_TRANS_COUNT to AL3_READ_ADDR_TRIG are an address_entry.
+//  One DMA transfer per cycle, ISRs and CPU code take no simulated time.
+
+static pio_hw_t pio_regs;
+static dma_hw_t dma_regs;
+static iobank0_hw_t iobank0_regs;
+static timer_hw_t timer_regs;
+static bus_ctrl_hw_t bus_ctrl_regs;
+pio_hw_t *pio0_hw = &pio_regs;
+dma_hw_t *dma_hw = &dma_regs;
+iobank0_hw_t *iobank0_hw = &iobank0_regs;
+timer_hw_t *timer_hw = &timer_regs;
+bus_ctrl_hw_t *bus_ctrl_hw = &bus_ctrl_regs;
+
+namespace Model {
+    uint64_t cycles = 0;
+    interrupts_t interrupts = {};
+    uint64_t isr_ns = 0;
+    uint32_t errors = 0;
+    void (*watch)(uint32_t pins) = nullptr;
+
+    // Instruction written into SMx_INSTR, executed instead of the next one
+    constexpr uint32_t forced_none = ~0u;
+
+    struct state_machine {
+        uint32_t pc = 0;
+        uint32_t x = 0;
+        uint32_t y = 0;
+        uint32_t osr = 0;
+        uint32_t isr = 0;
+        uint32_t osr_count = 32;                    // OSR is empty
+        uint32_t isr_count = 0;
+        uint32_t delay = 0;
+        double next = 0;                            // System clock cycle of the next PIO cycle
+        std::deque<uint32_t> tx;
+        std::deque<uint32_t> rx;
+    };
+
+    // Reload of TRANS_COUNT is taken at every trigger, READ_ADDR and WRITE_ADDR keep counting.
+    struct channel {
+        uintptr_t read = 0;
+        uintptr_t write = 0;
+        uint32_t count = 0;
+        uint32_t reload = 0;
+        uint32_t ctrl = 0;
+        uint32_t done = 0;                          // Transfers since the trigger (Timer pacing)
+        uint64_t triggered = 0;
+        uint32_t triggers = 0;
+        bool busy = false;
+    };
+
+    // Control blocks as the host lays them out (See PWM/matrix.cpp and BCM/matrix.cpp)
+    struct scan_block {const volatile void *read; volatile void *write; uint32_t len; uint32_t ctrl;};
+    struct address_entry {volatile uint32_t len; volatile uint8_t *data;};
+
+    static state_machine sm[4];
+    static uint32_t flags = 0;                      // PIO IRQ flags
+    static uint32_t pio_out = 0;                    // Pins driven by PIO0
+    static uint32_t sio_out = 0;                    // Pins driven by SIO
+    static uint32_t program_used = 0;               // Instruction memory in use
+    static uint32_t sm_enabled = 0;                 // State machines enabled at the last cycle
+    static channel dma[12];
+    static uint32_t dma_intr = 0;
+    static double dma_timer_period[4] = {};
+    static uint32_t dma_next = 0;                   // Round robin between channels
+    static uint32_t dma_claimed = 0;
+    static uint32_t timer_intr = 0;
+    static uint32_t timer_armed = 0;
+    static uint32_t timer_alarm[4] = {};
+    static bool running = false;
+    static bool dirty = true;
+
+    static const bool reset = []() {
+        for (auto &s : pio_regs.sm)
+            s.instr = forced_none;
+
+        for (auto &io : iobank0_regs.io)
+            io.ctrl = GPIO_FUNC_NULL << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB;
+
+        return true;
+    }();
+
+    uint32_t get_pins() {
+        uint32_t pins = 0;
+
+        for (uint32_t i = 0; i < 30; i++) {
+            const uint32_t ctrl = iobank0_regs.io[i].ctrl;
+            const uint32_t funcsel = (ctrl >> IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB) & 0x1F;
+            const uint32_t outover = (ctrl >> IO_BANK0_GPIO0_CTRL_OUTOVER_LSB) & 3;
+            bool v = (funcsel == GPIO_FUNC_SIO) ? ((sio_out >> i) & 1) : (funcsel == GPIO_FUNC_PIO0) ? ((pio_out >> i) & 1) : false;
+
+            if (outover == GPIO_OVERRIDE_INVERT)
+                v = !v;
+            else if (outover == GPIO_OVERRIDE_LOW)
+                v = false;
+            else if (outover == GPIO_OVERRIDE_HIGH)
+                v = true;
+
+            pins |= v << i;
+        }
+
+        return pins;
+    }
+
+    uint32_t get_pc(uint32_t index) {
+        return sm[index].pc;
+    }
+
+    uint32_t get_tx_level(uint32_t index) {
+        return sm[index].tx.size();
+    }
+
+    // -- PIO --
+
+    static void set_pins(uint32_t base, uint32_t count, uint32_t value) {
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t pin = (base + i) & 31;
+            pio_out = (pio_out & ~(1u << pin)) | (((value >> i) & 1) << pin);
+        }
+    }
+
+    static uint32_t get_threshold(uint32_t shiftctrl, uint32_t lsb) {
+        const uint32_t n = (shiftctrl >> lsb) & 31;
+        return (n == 0) ? 32 : n;
+    }
+
+    static bool push(state_machine &s) {
+        if (s.rx.size() >= 4)
+            return false;
+
+        s.rx.push_back(s.isr);
+        s.isr = 0;
+        s.isr_count = 0;
+        return true;
+    }
+
+    static bool pull(state_machine &s) {
+        if (s.tx.empty())
+            return false;
+
+        s.osr = s.tx.front();
+        s.tx.pop_front();
+        s.osr_count = 0;
+        return true;
+    }
+
+    // Runs one instruction, returns false if it stalled. The side set is applied either way.
+    static bool execute(uint32_t index, uint32_t instruction, uint32_t *next) {
+        state_machine &s = sm[index];
+        const pio_sm_hw_t &r = pio_regs.sm[index];
+        const uint32_t sideset_count = (r.pinctrl >> PIO_SM0_PINCTRL_SIDESET_COUNT_LSB) & 7;
+        const uint32_t index_bits = instruction & 31;
+        const uint32_t field = (instruction >> 5) & 7;
+        const bool shift_right_out = (r.shiftctrl >> PIO_SM0_SHIFTCTRL_OUT_SHIFTDIR_LSB) & 1;
+        const bool shift_right_in = (r.shiftctrl >> PIO_SM0_SHIFTCTRL_IN_SHIFTDIR_LSB) & 1;
+        const uint32_t pull_threshold = get_threshold(r.shiftctrl, PIO_SM0_SHIFTCTRL_PULL_THRESH_LSB);
+        const uint32_t push_threshold = get_threshold(r.shiftctrl, PIO_SM0_SHIFTCTRL_PUSH_THRESH_LSB);
+
+        if (sideset_count != 0)
+            set_pins((r.pinctrl >> PIO_SM0_PINCTRL_SIDESET_BASE_LSB) & 31, sideset_count, (instruction >> (13 - sideset_count)) & ((1 << sideset_count) - 1));
+
+        switch (instruction >> 13) {
+            case 0: {                                                       // JMP
+                bool taken = false;
+
+                switch (field) {
+                    case 0: taken = true; break;
+                    case 1: taken = s.x == 0; break;
+                    case 2: taken = s.x-- != 0; break;
+                    case 3: taken = s.y == 0; break;
+                    case 4: taken = s.y-- != 0; break;
+                    case 5: taken = s.x != s.y; break;
+                    case 7: taken = s.osr_count < pull_threshold; break;
+                    default: errors++; break;
+                }
+
+                if (taken)
+                    *next = index_bits;
+                break;
+            }
+            case 1: {                                                       // WAIT
+                const bool polarity = (instruction >> 7) & 1;
+                const uint32_t source = (instruction >> 5) & 3;
+
+                if (source == 0) {
+                    if (((get_pins() >> index_bits) & 1) != polarity)
+                        return false;
+                }
+                else if (source == 2) {
+                    const uint32_t irq = (index_bits & 0x10) ? ((index_bits & 4) | ((index_bits + index) & 3)) : (index_bits & 7);
+
+                    if (((flags >> irq) & 1) != polarity)
+                        return false;
+
+                    if (polarity)
+                        flags &= ~(1u << irq);
+                }
+                else
+                    errors++;
+                break;
+            }
+            case 2: {                                                       // IN
+                const uint32_t n = (index_bits == 0) ? 32 : index_bits;
+                const uint32_t mask = (n == 32) ? ~0u : ((1u << n) - 1);
+                uint32_t v = 0;
+
+                if (((r.shiftctrl >> PIO_SM0_SHIFTCTRL_AUTOPUSH_LSB) & 1) && (s.isr_count >= push_threshold) && !push(s))
+                    return false;
+
+                switch (field) {
+                    case 1: v = s.x; break;
+                    case 2: v = s.y; break;
+                    case 3: v = 0; break;
+                    case 6: v = s.isr; break;
+                    case 7: v = s.osr; break;
+                    default: errors++; break;
+                }
+
+                v &= mask;
+                s.isr = shift_right_in ? ((n == 32) ? v : ((s.isr >> n) | (v << (32 - n)))) : ((n == 32) ? v : ((s.isr << n) | v));
+                s.isr_count = (s.isr_count + n > 32) ? 32 : (s.isr_count + n);
+                break;
+            }
+            case 3: {                                                       // OUT
+                const uint32_t n = (index_bits == 0) ? 32 : index_bits;
+                uint32_t v;
+
+                if (((r.shiftctrl >> PIO_SM0_SHIFTCTRL_AUTOPULL_LSB) & 1) && (s.osr_count >= pull_threshold) && !pull(s))
+                    return false;
+
+                if (shift_right_out) {
+                    v = (n == 32) ? s.osr : (s.osr & ((1u << n) - 1));
+                    s.osr = (n == 32) ? 0 : (s.osr >> n);
+                }
+                else {
+                    v = (n == 32) ? s.osr : (s.osr >> (32 - n));
+                    s.osr = (n == 32) ? 0 : (s.osr << n);
+                }
+
+                s.osr_count = (s.osr_count + n > 32) ? 32 : (s.osr_count + n);
+
+                switch (field) {
+                    case 0: set_pins((r.pinctrl >> PIO_SM0_PINCTRL_OUT_BASE_LSB) & 31, (r.pinctrl >> PIO_SM0_PINCTRL_OUT_COUNT_LSB) & 63, v); break;
+                    case 1: s.x = v; break;
+                    case 2: s.y = v; break;
+                    case 3: break;
+                    case 5: *next = v & 31; break;
+                    default: errors++; break;
+                }
+                break;
+            }
+            case 4: {                                                       // PUSH, PULL
+                const bool conditional = (instruction >> 6) & 1;
+                const bool block = (instruction >> 5) & 1;
+
+                if (instruction & 0x80) {
+                    if (conditional && (s.osr_count < pull_threshold))
+                        break;
+
+                    if (!pull(s)) {
+                        if (block)
+                            return false;
+
+                        s.osr = s.x;
+                    }
+                }
+                else {
+                    if (conditional && (s.isr_count < push_threshold))
+                        break;
+
+                    if (!push(s)) {
+                        if (block)
+                            return false;
+
+                        errors++;                                           // Dropped, nobody is reading the RX FIFO
+                    }
+                }
+                break;
+            }
+            case 5: {                                                       // MOV
+                const uint32_t op = (instruction >> 3) & 3;
+                const uint32_t src = instruction & 7;
+                uint32_t v = 0;
+
+                switch (src) {
+                    case 0: v = get_pins(); break;
+                    case 1: v = s.x; break;
+                    case 2: v = s.y; break;
+                    case 3: v = 0; break;
+                    case 6: v = s.isr; break;
+                    case 7: v = s.osr; break;
+                    default: errors++; break;
+                }
+
+                if (op == 1)
+                    v = ~v;
+                else if (op == 2) {
+                    uint32_t b = 0;
+
+                    for (uint32_t i = 0; i < 32; i++)
+                        b |= ((v >> i) & 1) << (31 - i);
+
+                    v = b;
+                }
+
+                switch (field) {
+                    case 0: set_pins((r.pinctrl >> PIO_SM0_PINCTRL_OUT_BASE_LSB) & 31, (r.pinctrl >> PIO_SM0_PINCTRL_OUT_COUNT_LSB) & 63, v); break;
+                    case 1: s.x = v; break;
+                    case 2: s.y = v; break;
+                    case 5: *next = v & 31; break;
+                    case 6: s.isr = v; s.isr_count = 0; break;
+                    case 7: s.osr = v; s.osr_count = 0; break;
+                    default: errors++; break;
+                }
+                break;
+            }
+            case 6: {                                                       // IRQ (Wait is not used)
+                const uint32_t irq = (index_bits & 0x10) ? ((index_bits & 4) | ((index_bits + index) & 3)) : (index_bits & 7);
+
+                if (instruction & 0x20)
+                    errors++;
+
+                if (instruction & 0x40)
+                    flags &= ~(1u << irq);
+                else
+                    flags |= 1u << irq;
+                break;
+            }
+            case 7:                                                         // SET
+                switch (field) {
+                    case 0: set_pins((r.pinctrl >> PIO_SM0_PINCTRL_SET_BASE_LSB) & 31, (r.pinctrl >> PIO_SM0_PINCTRL_SET_COUNT_LSB) & 7, index_bits); break;
+                    case 1: s.x = index_bits; break;
+                    case 2: s.y = index_bits; break;
+                    case 4: break;
+                    default: errors++; break;
+                }
+                break;
+        }
+
+        s.delay = (instruction >> 8) & ((1 << (5 - sideset_count)) - 1);
+        return true;
+    }
+
+    static void step(uint32_t index) {
+        state_machine &s = sm[index];
+        pio_sm_hw_t &r = pio_regs.sm[index];
+        const uint32_t wrap_top = (r.execctrl >> PIO_SM0_EXECCTRL_WRAP_TOP_LSB) & 31;
+        const uint32_t wrap_bottom = (r.execctrl >> PIO_SM0_EXECCTRL_WRAP_BOTTOM_LSB) & 31;
+        uint32_t next = forced_none;
+
+        if (r.instr != forced_none) {
+            const uint32_t instruction = r.instr;
+            r.instr = forced_none;
+
+            if (execute(index, instruction, &next) && (next != forced_none))
+                s.pc = next;
+        }
+        else if (s.delay != 0)
+            s.delay--;
+        else if (execute(index, pio_regs.instr_mem[s.pc], &next))
+            s.pc = (next != forced_none) ? next : (s.pc == wrap_top) ? wrap_bottom : ((s.pc + 1) & 31);
+
+        r.addr = s.pc;
+        dirty = true;
+    }
+
+    static double get_divider(uint32_t index) {
+        const uint32_t clkdiv = pio_regs.sm[index].clkdiv;
+        const uint32_t integer = clkdiv >> PIO_SM0_CLKDIV_INT_LSB;
+        return ((integer == 0) ? 65536.0 : integer) + (((clkdiv >> PIO_SM0_CLKDIV_FRAC_LSB) & 0xFF) / 256.0);
+    }
+
+    // -- DMA --
+
+    static bool is_register(uintptr_t address, const volatile void *r) {
+        return address == (uintptr_t) r;
+    }
+
+    static void complete(uint32_t c);
+
+    static void trigger(uint32_t c) {
+        channel &ch = dma[c];
+
+        if (((ch.ctrl >> DMA_CH0_CTRL_TRIG_EN_LSB) & 1) == 0)
+            return;
+
+        ch.count = ch.reload;
+        ch.done = 0;
+        ch.triggered = cycles;
+        ch.triggers++;
+        ch.busy = true;
+
+        if (ch.count == 0)
+            complete(c);
+    }
+
+    static void raise(uint32_t c) {
+        dma_intr |= 1u << c;
+    }
+
+    static void complete(uint32_t c) {
+        channel &ch = dma[c];
+        const uint32_t chain = (ch.ctrl >> DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB) & 15;
+
+        ch.busy = false;
+
+        if (((ch.ctrl >> DMA_CH0_CTRL_TRIG_IRQ_QUIET_LSB) & 1) == 0)
+            raise(c);
+
+        if (chain != c)
+            trigger(chain);
+    }
+
+    static bool is_ready(uint32_t c) {
+        const channel &ch = dma[c];
+        const uint32_t treq = (ch.ctrl >> DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB) & 63;
+
+        if (!ch.busy)
+            return false;
+
+        if (treq == DREQ_FORCE)
+            return true;
+
+        if (treq < DREQ_PIO0_RX0)
+            return sm[treq].tx.size() < 4;
+
+        if (treq < DREQ_PIO1_TX0)
+            return !sm[treq - DREQ_PIO0_RX0].rx.empty();
+
+        if ((treq >= DREQ_DMA_TIMER0) && (treq < DREQ_FORCE)) {
+            const double period = dma_timer_period[treq - DREQ_DMA_TIMER0];
+            return (period != 0) && (cycles >= (ch.triggered + ((ch.done + 1) * period)));
+        }
+
+        errors++;
+        return false;
+    }
+
+    static uint32_t read_word(uintptr_t address, uint32_t size) {
+        uint32_t v = 0;
+
+        for (uint32_t i = 0; i < 4; i++) {
+            if (is_register(address, &pio_regs.rxf[i])) {
+                if (sm[i].rx.empty()) {
+                    errors++;
+                    return 0;
+                }
+
+                v = sm[i].rx.front();
+                sm[i].rx.pop_front();
+                return v;
+            }
+        }
+
+        memcpy(&v, (const void *) address, size);
+        return v;
+    }
+
+    static void write_word(uintptr_t address, uint32_t size, uint32_t v) {
+        for (uint32_t i = 0; i < 4; i++) {
+            if (is_register(address, &pio_regs.txf[i])) {
+                if (sm[i].tx.size() >= 4)
+                    errors++;
+                else
+                    sm[i].tx.push_back(v);
+                return;
+            }
+        }
+
+        if (is_register(address, &pio_regs.irq_force)) {
+            flags |= v & 0xFF;
+            return;
+        }
+
+        for (auto &io : iobank0_regs.io)
+            if (is_register(address, &io.status))
+                return;                                                     // Read only
+
+        if ((address >= (uintptr_t) &dma_regs) && (address < (uintptr_t) (&dma_regs + 1))) {
+            errors++;                                                       // Only whole control blocks (See transfer)
+            return;
+        }
+
+        memcpy((void *) address, &v, size);
+    }
+
+    static uintptr_t advance(uintptr_t address, uint32_t size, uint32_t ring) {
+        if (ring == 0)
+            return address + size;
+
+        const uintptr_t mask = (1u << ring) - 1;
+        return (address & ~mask) | ((address + size) & mask);
+    }
+
+    static void transfer(uint32_t c) {
+        channel &ch = dma[c];
+        const uint32_t size = 1 << ((ch.ctrl >> DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB) & 3);
+        const uint32_t ring = (ch.ctrl >> DMA_CH0_CTRL_TRIG_RING_SIZE_LSB) & 15;
+        const bool ring_write = (ch.ctrl >> DMA_CH0_CTRL_TRIG_RING_SEL_LSB) & 1;
+        const bool incr_read = (ch.ctrl >> DMA_CH0_CTRL_TRIG_INCR_READ_LSB) & 1;
+        const bool incr_write = (ch.ctrl >> DMA_CH0_CTRL_TRIG_INCR_WRITE_LSB) & 1;
+
+        for (uint32_t k = 0; k < 12; k++) {
+            // Control block, read address to control and trigger
+            if (is_register(ch.write, &dma_regs.ch[k].read_addr) && (ch.count == 4)) {
+                const scan_block *b = (const scan_block *) ch.read;
+
+                dma[k].read = (uintptr_t) b->read;
+                dma[k].write = (uintptr_t) b->write;
+                dma[k].reload = b->len;
+                dma[k].ctrl = b->ctrl;
+                ch.read += incr_read ? sizeof(scan_block) : 0;
+                ch.count = 0;
+                ch.done += 4;
+                complete(c);
+                trigger(k);
+                return;
+            }
+
+            // Address entry, transfer count and read address with trigger
+            //  Null trigger ends the chain and raises the interrupt of a quiet channel.
+            if (is_register(ch.write, &dma_regs.ch[k].al3_transfer_count) && (ch.count == 2)) {
+                const address_entry *e = (const address_entry *) ch.read;
+
+                dma[k].reload = e->len;
+                ch.read += incr_read ? sizeof(address_entry) : 0;
+                ch.count = 0;
+                ch.done += 2;
+                complete(c);
+
+                if (e->data == nullptr) {
+                    if ((dma[k].ctrl >> DMA_CH0_CTRL_TRIG_IRQ_QUIET_LSB) & 1)
+                        raise(k);
+                }
+                else {
+                    dma[k].read = (uintptr_t) e->data;
+                    trigger(k);
+                }
+                return;
+            }
+        }
+
+        write_word(ch.write, size, read_word(ch.read, size));
+        ch.read = incr_read ? advance(ch.read, size, ring_write ? 0 : ring) : ch.read;
+        ch.write = incr_write ? advance(ch.write, size, ring_write ? ring : 0) : ch.write;
+        ch.done++;
+        dirty = true;
+
+        if (--ch.count == 0)
+            complete(c);
+    }
+
+    uint32_t get_dma_triggers(uint32_t c) {
+        return dma[c].triggers;
+    }
+
+    uint32_t get_dma_count(uint32_t c) {
+        return dma[c].reload;
+    }
+
+    // -- Timer --
+
+    static uint32_t get_time_us() {
+        return (uint32_t) (cycles / 125);
+    }
+
+    // -- CPU --
+
+    void sync() {
+        flags |= pio_regs.irq_force & 0xFF;
+        flags &= ~pio_regs.irq;
+        pio_regs.irq_force = 0;
+        pio_regs.irq = 0;
+
+        for (uint32_t i = 0; i < 4; i++)
+            if (timer_regs.armed & (1u << i))
+                timer_alarm[i] = timer_regs.alarm[i];
+
+        timer_armed |= timer_regs.armed;
+        timer_regs.armed = 0;
+        dirty = true;
+    }
+
+    template <typename F> static void call(F isr, uint32_t *count) {
+        const uint64_t start = Test::now_ns();
+
+        isr();
+        isr_ns += Test::now_ns() - start;
+        (*count)++;
+        sync();
+    }
+
+    // Takes the highest pending interrupt, one per cycle.
+    static void interrupt() {
+        const uint32_t pio_pending = ((flags & 0xF) << 8) & pio_regs.inte0;
+        const uint32_t dma_pending = dma_intr & dma_regs.inte0;
+        const uint32_t timer_pending = timer_intr & timer_regs.inte;
+
+        if (dma_pending) {
+            dma_regs.ints0 = dma_pending;
+            dma_regs.intr = 0;
+            call(Matrix::dma_isr, &interrupts.dma);
+            dma_intr &= ~dma_regs.intr;
+            dma_regs.ints0 = 0;
+        }
+        else if (pio_pending) {
+            pio_regs.ints0 = pio_pending;
+            pio_regs.irq = 0;
+            call(Matrix::pio_isr, &interrupts.pio);
+            pio_regs.ints0 = 0;
+        }
+        else if (timer_pending) {
+            timer_regs.ints = timer_pending;
+            timer_regs.intr = 0;
+            call(Matrix::timer_isr, &interrupts.timer);
+            timer_intr &= ~timer_regs.intr;
+            timer_regs.ints = 0;
+        }
+    }
+
+    void run(uint64_t n) {
+        const bool nested = running;
+        running = true;
+
+        for (uint64_t i = 0; i < n; i++, cycles++) {
+            const uint32_t enabled = (pio_regs.ctrl >> PIO_CTRL_SM_ENABLE_LSB) & 0xF;
+
+            // Clock divider starts with the state machine, a disabled one does not catch up on its cycles.
+            for (uint32_t j = 0; j < 4; j++)
+                if ((enabled & ~sm_enabled) & (1u << j))
+                    sm[j].next = cycles;
+
+            sm_enabled = enabled;
+
+            for (uint32_t j = 0; j < 4; j++) {
+                if ((enabled & (1u << j)) && (cycles >= sm[j].next)) {
+                    sm[j].next += get_divider(j);
+                    step(j);
+                }
+            }
+
+            for (uint32_t j = 0; j < 12; j++) {
+                const uint32_t c = (dma_next + j) % 12;
+
+                if (is_ready(c)) {
+                    transfer(c);
+                    dma_next = c + 1;
+                    break;
+                }
+            }
+
+            // Alarm compares every microsecond, a time in the past is missed like on the hardware.
+            if (timer_armed && ((cycles % 125) == 0)) {
+                for (uint32_t j = 0; j < 4; j++) {
+                    if ((timer_armed & (1u << j)) && (timer_alarm[j] == get_time_us())) {
+                        timer_armed &= ~(1u << j);
+                        timer_intr |= 1u << j;
+                    }
+                }
+            }
+
+            interrupt();
+
+            if (dirty && (watch != nullptr))
+                watch(get_pins());
+
+            dirty = false;
+        }
+
+        running = nested;
+    }
+}
+
+using namespace Model;
+
+uint32_t time_us_32() {
+    return get_time_us();
+}
+
+int hardware_alarm_claim_unused(bool required) {
+    static int next = 0;
+    return next++;
+}
+
+// -- GPIO --
+
+void gpio_init(uint gpio) {
+    iobank0_regs.io[gpio].ctrl = GPIO_FUNC_SIO << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB;
+    sio_out &= ~(1u << gpio);
+    dirty = true;
+}
+
+void gpio_set_dir(uint gpio, bool out) {}
+
+void gpio_set_function(uint gpio, gpio_function fn) {
+    iobank0_regs.io[gpio].ctrl = fn << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB;
+    dirty = true;
+}
+
+void gpio_set_mask(uint32_t mask) {
+    sio_out |= mask;
+    dirty = true;
+}
+
+void gpio_clr_mask(uint32_t mask) {
+    sio_out &= ~mask;
+    dirty = true;
+}
+
+// -- PIO --
+
+// Programs without an origin are placed at the highest free offset, jumps are relocated.
+uint pio_add_program(PIO p, const pio_program *program) {
+    const uint32_t mask = (1u << program->length) - 1;
+    int offset = program->origin;
+
+    if (offset < 0)
+        for (offset = 32 - program->length; (offset >= 0) && (program_used & (mask << offset)); offset--);
+
+    if ((offset < 0) || (program_used & (mask << offset)))
+        errors++;
+
+    for (uint32_t i = 0; i < program->length; i++) {
+        const uint16_t instruction = program->instructions[i];
+        pio_regs.instr_mem[offset + i] = ((instruction >> 13) == 0) ? (instruction + offset) : instruction;
+    }
+
+    program_used |= mask << offset;
+    return offset;
+}
+
+// Instruction memory is free again, a program which was not loaded there is an error.
+void pio_remove_program(PIO p, const pio_program *program, uint loaded_offset) {
+    const uint32_t mask = ((1u << program->length) - 1) << loaded_offset;
+
+    if ((program_used & mask) != mask)
+        errors++;
+
+    program_used &= ~mask;
+}
+
+void pio_sm_set_consecutive_pindirs(PIO p, uint sm_index, uint pin_base, uint pin_count, bool is_out) {}
+void pio_sm_claim(PIO p, uint sm_index) {}
+void pio_sm_unclaim(PIO p, uint sm_index) {}
+
+void pio_sm_clear_fifos(PIO p, uint sm_index) {
+    sm[sm_index].tx.clear();
+    sm[sm_index].rx.clear();
+}
+
+// Shift counters and delay are reset, PC, X and Y are kept. (OSR is empty)
+void pio_sm_restart(PIO p, uint sm_index) {
+    sm[sm_index].isr = 0;
+    sm[sm_index].isr_count = 0;
+    sm[sm_index].osr_count = 32;
+    sm[sm_index].delay = 0;
+}
+
+// Output latch of the pins, like the SET instructions the SDK executes on the state machine
+void pio_sm_set_pins_with_mask(PIO p, uint sm_index, uint32_t pin_values, uint32_t pin_mask) {
+    pio_out = (pio_out & ~pin_mask) | (pin_values & pin_mask);
+    dirty = true;
+}
+
+void pio_sm_put(PIO p, uint sm_index, uint32_t data) {
+    if (sm[sm_index].tx.size() >= 4)
+        errors++;
+    else
+        sm[sm_index].tx.push_back(data);
+}
+
+// CPU waits, the hardware runs meanwhile. (Not from an ISR)
+void pio_sm_put_blocking(PIO p, uint sm_index, uint32_t data) {
+    while (!running && (sm[sm_index].tx.size() >= 4))
+        run(1);
+
+    pio_sm_put(p, sm_index, data);
+}
+
+bool pio_sm_is_tx_fifo_empty(PIO p, uint sm_index) {
+    if (!running)
+        run(1);
+
+    return sm[sm_index].tx.empty();
+}
+
+bool pio_sm_is_rx_fifo_empty(PIO p, uint sm_index) {
+    return sm[sm_index].rx.empty();
+}
+
+// -- DMA --
+
+// Lowest free channel like the SDK
+int dma_claim_unused_channel(bool required) {
+    for (int c = 0; c < 12; c++) {
+        if ((dma_claimed & (1u << c)) == 0) {
+            dma_claimed |= 1u << c;
+            return c;
+        }
+    }
+
+    errors++;
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel) {
+    if ((dma_claimed & (1u << channel)) == 0)
+        errors++;
+
+    dma_claimed &= ~(1u << channel);
+}
+
+int dma_claim_unused_timer(bool required) {
+    static int next = 0;
+    return next++;
+}
+
+void dma_timer_set_fraction(uint timer, uint16_t numerator, uint16_t denominator) {
+    dma_timer_period[timer] = (double) denominator / numerator;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr, const volatile void *read_addr, uint transfer_count, bool trigger) {
+    dma[channel].ctrl = config->ctrl;
+    dma[channel].write = (uintptr_t) write_addr;
+    dma[channel].read = (uintptr_t) read_addr;
+    dma[channel].reload = transfer_count;
+
+    if (trigger)
+        Model::trigger(channel);
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger) {
+    dma[channel].read = (uintptr_t) read_addr;
+
+    if (trigger)
+        Model::trigger(channel);
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+    dma_regs.inte0 = enabled ? (dma_regs.inte0 | (1u << channel)) : (dma_regs.inte0 & ~(1u << channel));
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count) {
+    dma[channel].read = (uintptr_t) read_addr;
+    dma[channel].reload = transfer_count;
+    Model::trigger(channel);
+}
+
+bool dma_channel_is_busy(uint channel) {
+    return dma[channel].busy;
+}
+
+// Stops the channel without completing it, no chain and no interrupt.
+void dma_channel_abort(uint channel) {
+    dma[channel].busy = false;
+    dma[channel].count = 0;
+    dma_intr &= ~(1u << channel);
+}
@@ -0,0 +1,62 @@
+/* 
+ * File:   model.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_MODEL_H
+#define TEST_MODEL_H
+
+#include <stdint.h>
+
+// Hardware model of the RP2040 for waveform tests (See model.cpp)
+//  PIO0, DMA, GPIO and the timer run in 125MHz system clock cycles, the ISRs of matrix.cpp are called like the NVIC would.
+//  Registers and the SDK calls of the stubs are defined by the model, a test only links model.cpp.
+//  ISRs take no simulated time, their host time and count are measured instead.
+namespace Model {
+    // Simulated time in system clock cycles
+    extern uint64_t cycles;
+
+    // Interrupts taken by the ISRs of matrix.cpp
+    struct interrupts_t {
+        uint32_t pio;
+        uint32_t dma;
+        uint32_t timer;
+    };
+
+    extern interrupts_t interrupts;
+    extern uint64_t isr_ns;                         // Host time spent in the ISRs
+
+    // Things the model can not do or the hardware would not do (FIFO overflow, unsupported instruction, unknown DREQ)
+    extern uint32_t errors;
+
+    // Called with the level of every GPIO whenever a pin may have changed, cycles is the time of the change.
+    extern void (*watch)(uint32_t pins);
+
+    uint32_t get_pins();
+    uint32_t get_pc(uint32_t sm);
+    uint32_t get_tx_level(uint32_t sm);
+
+    // Triggers of a DMA channel and the transfer count of the last one
+    uint32_t get_dma_triggers(uint32_t channel);
+    uint32_t get_dma_count(uint32_t channel);
+
+    // Applies what the CPU wrote outside of an ISR (IRQ force, armed alarms)
+    void sync();
+
+    void run(uint64_t n);
+
+    // Runs until the condition holds, at most limit cycles.
+    template <typename F> bool run_until(F f, uint64_t limit) {
+        for (uint64_t i = 0; i < limit; i += 100) {
+            if (f())
+                return true;
+
+            run(100);
+        }
+
+        return f();
+    }
+}
+
+#endif
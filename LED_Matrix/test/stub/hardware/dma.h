@@ -0,0 +1,101 @@
+/* 
+ * File:   dma.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_STUB_HARDWARE_DMA_H
+#define TEST_STUB_HARDWARE_DMA_H
+
+#include "pico/platform.h"
+
+// Registers are plain memory, the hardware model defines dma_hw and the calls. (See test/model.cpp)
+//  Field positions of CTRL and the DREQ numbers are the ones of the RP2040 datasheet.
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+struct dma_channel_hw_t {
+    io_rw_32 read_addr;
+    io_rw_32 write_addr;
+    io_rw_32 transfer_count;
+    io_rw_32 ctrl_trig;
+    io_rw_32 al1_ctrl;
+    io_rw_32 al1_read_addr;
+    io_rw_32 al1_write_addr;
+    io_rw_32 al1_transfer_count_trig;
+    io_rw_32 al2_ctrl;
+    io_rw_32 al2_transfer_count;
+    io_rw_32 al2_read_addr;
+    io_rw_32 al2_write_addr_trig;
+    io_rw_32 al3_ctrl;
+    io_rw_32 al3_write_addr;
+    io_rw_32 al3_transfer_count;
+    io_rw_32 al3_read_addr_trig;
+};
+
+struct dma_hw_t {
+    dma_channel_hw_t ch[12];
+    io_rw_32 intr;
+    io_rw_32 inte0;
+    io_rw_32 intf0;
+    io_rw_32 ints0;
+};
+
+extern dma_hw_t *dma_hw;
+
+#define DMA_CH0_CTRL_TRIG_EN_LSB 0
+#define DMA_CH0_CTRL_TRIG_HIGH_PRIORITY_LSB 1
+#define DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB 2
+#define DMA_CH0_CTRL_TRIG_INCR_READ_LSB 4
+#define DMA_CH0_CTRL_TRIG_INCR_WRITE_LSB 5
+#define DMA_CH0_CTRL_TRIG_RING_SIZE_LSB 6
+#define DMA_CH0_CTRL_TRIG_RING_SEL_LSB 10
+#define DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB 11
+#define DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB 15
+#define DMA_CH0_CTRL_TRIG_IRQ_QUIET_LSB 21
+
+enum { DREQ_PIO0_TX0 = 0, DREQ_PIO0_RX0 = 4, DREQ_PIO1_TX0 = 8, DREQ_PIO1_RX0 = 12, DREQ_DMA_TIMER0 = 0x3b, DREQ_FORCE = 0x3f };
+
+struct dma_channel_config {
+    uint32_t ctrl;
+};
+
+static inline void channel_config_set_bits(dma_channel_config *c, uint32_t lsb, uint32_t width, uint32_t value) {
+    c->ctrl = (c->ctrl & ~(((1u << width) - 1) << lsb)) | (value << lsb);
+}
+
+// Enabled, 32-bit, read increment, chained to itself (no chain), unpaced
+static inline dma_channel_config dma_channel_get_default_config(uint channel) {
+    return { (1u << DMA_CH0_CTRL_TRIG_EN_LSB) | (DMA_SIZE_32 << DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB) | (1u << DMA_CH0_CTRL_TRIG_INCR_READ_LSB) |
+        (channel << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB) | (DREQ_FORCE << DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB) };
+}
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, dma_channel_transfer_size size) { channel_config_set_bits(c, DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB, 2, size); }
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) { channel_config_set_bits(c, DMA_CH0_CTRL_TRIG_INCR_READ_LSB, 1, incr); }
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) { channel_config_set_bits(c, DMA_CH0_CTRL_TRIG_INCR_WRITE_LSB, 1, incr); }
+static inline void channel_config_set_high_priority(dma_channel_config *c, bool high_priority) { channel_config_set_bits(c, DMA_CH0_CTRL_TRIG_HIGH_PRIORITY_LSB, 1, high_priority); }
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) { channel_config_set_bits(c, DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB, 6, dreq); }
+static inline void channel_config_set_chain_to(dma_channel_config *c, uint chain_to) { channel_config_set_bits(c, DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB, 4, chain_to); }
+static inline void channel_config_set_irq_quiet(dma_channel_config *c, bool irq_quiet) { channel_config_set_bits(c, DMA_CH0_CTRL_TRIG_IRQ_QUIET_LSB, 1, irq_quiet); }
+static inline uint32_t channel_config_get_ctrl_value(const dma_channel_config *c) { return c->ctrl; }
+
+static inline void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) {
+    channel_config_set_bits(c, DMA_CH0_CTRL_TRIG_RING_SIZE_LSB, 4, size_bits);
+    channel_config_set_bits(c, DMA_CH0_CTRL_TRIG_RING_SEL_LSB, 1, write);
+}
+
+static inline uint dma_get_timer_dreq(uint timer_num) { return DREQ_DMA_TIMER0 + timer_num; }
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+int dma_claim_unused_timer(bool required);
+void dma_timer_set_fraction(uint timer, uint16_t numerator, uint16_t denominator);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr, const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_abort(uint channel);
+
+static inline bool dma_channel_get_irq0_status(uint channel) { return dma_hw->ints0 & (1u << channel); }
+
+#endif
@@ -0,0 +1,23 @@
+/* 
+ * File:   flash.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_STUB_HARDWARE_FLASH_H
+#define TEST_STUB_HARDWARE_FLASH_H
+
+#include "pico/platform.h"
+
+// Flash is a host array read through XIP_BASE, it starts out erased. (See stub.cpp)
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+#define XIP_BASE ((uintptr_t) stub_flash)
+
+extern uint8_t stub_flash[PICO_FLASH_SIZE_BYTES];
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+#endif
@@ -0,0 +1,23 @@
+/* 
+ * File:   gpio.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_STUB_HARDWARE_GPIO_H
+#define TEST_STUB_HARDWARE_GPIO_H
+
+#include "pico/platform.h"
+
+// Declarations only, a test or the hardware model defines what it calls (See test/model.cpp)
+enum { GPIO_IN = 0, GPIO_OUT = 1 };
+enum gpio_function { GPIO_FUNC_UART = 2, GPIO_FUNC_SIO = 5, GPIO_FUNC_PIO0 = 6, GPIO_FUNC_PIO1 = 7, GPIO_FUNC_NULL = 0x1f };
+enum { GPIO_OVERRIDE_NORMAL = 0, GPIO_OVERRIDE_INVERT = 1, GPIO_OVERRIDE_LOW = 2, GPIO_OVERRIDE_HIGH = 3 };
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_set_function(uint gpio, gpio_function fn);
+void gpio_set_mask(uint32_t mask);
+void gpio_clr_mask(uint32_t mask);
+
+#endif
@@ -0,0 +1,101 @@
+/* 
+ * File:   pio.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_STUB_HARDWARE_PIO_H
+#define TEST_STUB_HARDWARE_PIO_H
+
+#include "pico/platform.h"
+#include "hardware/gpio.h"
+
+// Registers are plain memory, the hardware model defines pio0_hw and the calls. (See test/model.cpp)
+//  Field positions and instruction encodings are the ones of the RP2040 datasheet.
+struct pio_sm_hw_t {
+    io_rw_32 clkdiv;
+    io_rw_32 execctrl;
+    io_rw_32 shiftctrl;
+    io_ro_32 addr;
+    io_rw_32 instr;
+    io_rw_32 pinctrl;
+};
+
+struct pio_hw_t {
+    io_rw_32 ctrl;
+    io_wo_32 txf[4];
+    io_ro_32 rxf[4];
+    io_rw_32 irq;
+    io_wo_32 irq_force;
+    io_wo_32 instr_mem[32];
+    pio_sm_hw_t sm[4];
+    io_rw_32 inte0;
+    io_ro_32 ints0;
+};
+
+typedef pio_hw_t *PIO;
+extern pio_hw_t *pio0_hw;
+#define pio0 pio0_hw
+
+struct pio_program {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+};
+
+enum pio_src_dest { pio_pins = 0, pio_x = 1, pio_y = 2, pio_null = 3, pio_pc = 5, pio_isr = 6, pio_osr = 7 };
+
+#define PIO_SM0_CLKDIV_INT_LSB 16
+#define PIO_SM0_CLKDIV_FRAC_LSB 8
+#define PIO_SM0_EXECCTRL_WRAP_TOP_LSB 12
+#define PIO_SM0_EXECCTRL_WRAP_BOTTOM_LSB 7
+#define PIO_SM1_EXECCTRL_WRAP_TOP_LSB 12
+#define PIO_SM1_EXECCTRL_OUT_STICKY_LSB 17
+#define PIO_SM0_SHIFTCTRL_AUTOPUSH_LSB 16
+#define PIO_SM0_SHIFTCTRL_AUTOPULL_LSB 17
+#define PIO_SM0_SHIFTCTRL_IN_SHIFTDIR_LSB 18
+#define PIO_SM0_SHIFTCTRL_OUT_SHIFTDIR_LSB 19
+#define PIO_SM0_SHIFTCTRL_PUSH_THRESH_LSB 20
+#define PIO_SM0_SHIFTCTRL_PULL_THRESH_LSB 25
+#define PIO_SM0_PINCTRL_OUT_BASE_LSB 0
+#define PIO_SM0_PINCTRL_SET_BASE_LSB 5
+#define PIO_SM0_PINCTRL_SIDESET_BASE_LSB 10
+#define PIO_SM0_PINCTRL_OUT_COUNT_LSB 20
+#define PIO_SM0_PINCTRL_SET_COUNT_LSB 26
+#define PIO_SM0_PINCTRL_SIDESET_COUNT_LSB 29
+#define PIO_CTRL_SM_ENABLE_LSB 0
+#define PIO_IRQ0_INTE_SM0_BITS 0x00000100
+#define PIO_IRQ0_INTE_SM1_BITS 0x00000200
+#define PIO_IRQ0_INTS_SM0_BITS 0x00000100
+#define PIO_IRQ0_INTS_SM1_BITS 0x00000200
+
+uint pio_add_program(PIO pio, const pio_program *program);
+void pio_remove_program(PIO pio, const pio_program *program, uint loaded_offset);
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out);
+void pio_sm_claim(PIO pio, uint sm);
+void pio_sm_unclaim(PIO pio, uint sm);
+void pio_sm_clear_fifos(PIO pio, uint sm);
+void pio_sm_restart(PIO pio, uint sm);
+void pio_sm_put(PIO pio, uint sm, uint32_t data);
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values, uint32_t pin_mask);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm);
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+
+static inline uint pio_encode_sideset(uint sideset_bit_count, uint value) { return value << (13 - sideset_bit_count); }
+static inline uint pio_encode_jmp(uint addr) { return addr; }
+static inline uint pio_encode_jmp_not_x(uint addr) { return (1 << 5) | addr; }
+static inline uint pio_encode_jmp_x_dec(uint addr) { return (2 << 5) | addr; }
+static inline uint pio_encode_jmp_y_dec(uint addr) { return (4 << 5) | addr; }
+static inline uint pio_encode_jmp_not_y(uint addr) { return (3 << 5) | addr; }
+static inline uint pio_encode_wait_irq(bool polarity, bool relative, uint irq) { return 0x2000 | (polarity << 7) | (2 << 5) | (relative << 4) | irq; }
+static inline uint pio_encode_in(pio_src_dest src, uint count) { return 0x4000 | (src << 5) | (count & 31); }
+static inline uint pio_encode_out(pio_src_dest dest, uint count) { return 0x6000 | (dest << 5) | (count & 31); }
+static inline uint pio_encode_push(bool if_full, bool block) { return 0x8000 | (if_full << 6) | (block << 5); }
+static inline uint pio_encode_pull(bool if_empty, bool block) { return 0x8080 | (if_empty << 6) | (block << 5); }
+static inline uint pio_encode_mov(pio_src_dest dest, pio_src_dest src) { return 0xA000 | (dest << 5) | src; }
+static inline uint pio_encode_nop() { return pio_encode_mov(pio_y, pio_y); }
+static inline uint pio_encode_irq_set(bool relative, uint irq) { return 0xC000 | (relative << 4) | irq; }
+static inline uint pio_encode_set(pio_src_dest dest, uint value) { return 0xE000 | (dest << 5) | value; }
+
+#endif
@@ -0,0 +1,19 @@
+/* 
+ * File:   bus_ctrl.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_STUB_HARDWARE_STRUCTS_BUS_CTRL_H
+#define TEST_STUB_HARDWARE_STRUCTS_BUS_CTRL_H
+
+#include "pico/platform.h"
+
+// Register is plain memory, a test defines bus_ctrl_hw
+struct bus_ctrl_hw_t {
+    io_rw_32 priority;
+};
+
+extern bus_ctrl_hw_t *bus_ctrl_hw;
+
+#endif
@@ -0,0 +1,26 @@
+/* 
+ * File:   iobank0.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_STUB_HARDWARE_STRUCTS_IOBANK0_H
+#define TEST_STUB_HARDWARE_STRUCTS_IOBANK0_H
+
+#include "pico/platform.h"
+
+// Registers are plain memory, the hardware model defines iobank0_hw. (See test/model.cpp)
+//  Status is read only, the model drops writes to it.
+struct iobank0_hw_t {
+    struct {
+        io_ro_32 status;
+        io_rw_32 ctrl;
+    } io[30];
+};
+
+extern iobank0_hw_t *iobank0_hw;
+
+#define IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB 0
+#define IO_BANK0_GPIO0_CTRL_OUTOVER_LSB 8
+
+#endif
@@ -0,0 +1,23 @@
+/* 
+ * File:   sync.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_STUB_HARDWARE_SYNC_H
+#define TEST_STUB_HARDWARE_SYNC_H
+
+#include "pico/platform.h"
+
+// Spinlocks are host locks, interrupts do not exist. (See stub.cpp)
+typedef volatile uint32_t spin_lock_t;
+
+static inline uint32_t save_and_disable_interrupts() { return 0; }
+static inline void restore_interrupts(uint32_t) {}
+
+int spin_lock_claim_unused(bool required);
+spin_lock_t *spin_lock_init(uint lock_num);
+uint32_t spin_lock_blocking(spin_lock_t *lock);
+void spin_unlock(spin_lock_t *lock, uint32_t saved_irq);
+
+#endif
@@ -0,0 +1,29 @@
+/* 
+ * File:   timer.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_STUB_HARDWARE_TIMER_H
+#define TEST_STUB_HARDWARE_TIMER_H
+
+#include "pico/platform.h"
+
+// Microseconds since the start of the test (See stub.cpp and model.cpp)
+uint32_t time_us_32();
+uint64_t time_us_64();
+
+// Alarm registers are plain memory, a test or the hardware model defines timer_hw and hardware_alarm_claim_unused.
+struct timer_hw_t {
+    io_rw_32 alarm[4];
+    io_rw_32 armed;
+    io_rw_32 intr;
+    io_rw_32 inte;
+    io_ro_32 ints;
+};
+
+extern timer_hw_t *timer_hw;
+
+int hardware_alarm_claim_unused(bool required);
+
+#endif
@@ -0,0 +1,24 @@
+/* 
+ * File:   uart.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_STUB_HARDWARE_UART_H
+#define TEST_STUB_HARDWARE_UART_H
+
+#include "pico/platform.h"
+
+// Declarations only, a test defines what it calls
+struct uart_hw_t { io_rw_32 dr, rsr, fr, ilpr, ibrd, fbrd, lcr_h, cr, ifls, imsc, ris, mis, icr; };
+typedef struct uart_inst uart_inst_t;
+
+extern uart_hw_t *uart0_hw;
+extern uart_inst_t *uart0;
+
+uint uart_init(uart_inst_t *uart, uint baudrate);
+bool uart_is_readable(uart_inst_t *uart);
+char uart_getc(uart_inst_t *uart);
+void uart_putc(uart_inst_t *uart, char c);
+
+#endif
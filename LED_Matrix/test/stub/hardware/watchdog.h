@@ -0,0 +1,16 @@
+/* 
+ * File:   watchdog.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_STUB_HARDWARE_WATCHDOG_H
+#define TEST_STUB_HARDWARE_WATCHDOG_H
+
+#include "pico/platform.h"
+
+// Watchdog does nothing on the host (See stub.cpp)
+void watchdog_update();
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug);
+
+#endif
@@ -0,0 +1,17 @@
+/* 
+ * File:   endian.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_STUB_MACHINE_ENDIAN_H
+#define TEST_STUB_MACHINE_ENDIAN_H
+
+// Host stand in for the newlib header used by System/machine.h
+#include <endian.h>
+#include <byteswap.h>
+
+#define __bswap16(x) bswap_16(x)
+#define __bswap32(x) bswap_32(x)
+
+#endif
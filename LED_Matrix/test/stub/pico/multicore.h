@@ -0,0 +1,26 @@
+/* 
+ * File:   multicore.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_STUB_PICO_MULTICORE_H
+#define TEST_STUB_PICO_MULTICORE_H
+
+#include "pico/platform.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+// Tests run on one core, the FIFO is always empty and never full. (See stub.cpp)
+struct sio_hw_t {
+    io_rw_32 fifo_st;
+    io_rw_32 fifo_wr;
+    io_rw_32 fifo_rd;
+};
+
+extern sio_hw_t *sio_hw;
+
+static inline bool multicore_fifo_rvalid() { return false; }
+static inline bool multicore_fifo_wready() { return true; }
+
+#endif
@@ -0,0 +1,32 @@
+/* 
+ * File:   platform.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_STUB_PICO_PLATFORM_H
+#define TEST_STUB_PICO_PLATFORM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Host stand in for the few pico-sdk names used by the sources under test
+#define __not_in_flash_func(x) x
+
+typedef unsigned int uint;
+typedef volatile uint32_t io_rw_32;
+typedef volatile uint32_t io_ro_32;
+typedef volatile uint32_t io_wo_32;
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+static inline void hw_set_bits(io_rw_32 *addr, uint32_t mask) { *addr |= mask; }
+static inline void hw_clear_bits(io_rw_32 *addr, uint32_t mask) { *addr &= ~mask; }
+
+// Tests run on one core (See hardware/sync.h)
+static inline void __wfe() {}
+static inline void __sev() {}
+static inline void tight_loop_contents() {}
+static inline uint get_core_num() { return 0; }
+
+#endif
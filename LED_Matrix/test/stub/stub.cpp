@@ -0,0 +1,74 @@
+/* 
+ * File:   stub.cpp
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#include <string.h>
+#include <mutex>
+#include <chrono>
+#include "pico/multicore.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/flash.h"
+#include "hardware/watchdog.h"
+
+// Definitions of the stubs which are not inline, shared by the tests which build worker sources.
+
+static sio_hw_t sio;
+sio_hw_t *sio_hw = &sio;
+
+// Host clock, the hardware model replaces it with simulated time. (See model.cpp)
+__attribute__((weak)) uint32_t time_us_32() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+__attribute__((weak)) uint64_t time_us_64() {
+    return time_us_32();
+}
+
+// Spinlock number is the index of a host mutex
+static spin_lock_t locks[32];
+static std::mutex mutexes[32];
+
+int spin_lock_claim_unused(bool required) {
+    static int next = 0;
+    return next++;
+}
+
+spin_lock_t *spin_lock_init(uint lock_num) {
+    return &locks[lock_num];
+}
+
+uint32_t spin_lock_blocking(spin_lock_t *lock) {
+    mutexes[lock - locks].lock();
+    return 0;
+}
+
+void spin_unlock(spin_lock_t *lock, uint32_t saved_irq) {
+    mutexes[lock - locks].unlock();
+}
+
+// Erased flash reads 0xFF
+uint8_t stub_flash[PICO_FLASH_SIZE_BYTES];
+
+static const bool erased = []() {
+    memset(stub_flash, 0xFF, sizeof(stub_flash));
+    return true;
+}();
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    memset(stub_flash + flash_offs, 0xFF, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        stub_flash[flash_offs + i] &= data[i];
+}
+
+void watchdog_update() {
+}
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug) {
+}
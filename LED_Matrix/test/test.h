@@ -0,0 +1,35 @@
+/* 
+ * File:   test.h
+ * Author: David Thacher
+ * License: GPL 3.0
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+
+namespace Test {
+    // Failed checks (See CHECK)
+    inline uint32_t failures = 0;
+
+    // Result of main, zero if every check passed
+    inline int result() {
+        if (failures != 0)
+            printf("%u checks failed\n", failures);
+
+        return (failures == 0) ? 0 : 1;
+    }
+
+    // Wall clock for the benchmarks
+    inline uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+// Counts the failure and keeps going, so one run reports every broken case.
+#define CHECK(x) do { if (!(x)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); Test::failures++; } } while (0)
+
+#endif